@@ -109,4 +109,29 @@ static inline bool atomic_bit_set_acquire_release_64(uint64_t *loc, int bit)
 	return ((val & mask) != 0UL);
 }
 
+/*
+ * Atomically replace the bits @mask of the 64-bit value stored at memory
+ * location @loc with @val. @val must not have any bit set outside of @mask.
+ */
+static inline void atomic_bits_write_64(uint64_t *loc, uint64_t mask,
+					uint64_t val)
+{
+	uint64_t tmp;
+	unsigned int status;
+
+	asm volatile(
+	"1:	ldxr	%[tmp], %[loc]\n"
+	"	bic	%[tmp], %[tmp], %[mask]\n"
+	"	orr	%[tmp], %[tmp], %[val]\n"
+	"	stxr	%w[status], %[tmp], %[loc]\n"
+	"	cbnz	%w[status], 1b\n"
+	: [loc] "+Q" (*loc),
+	  [tmp] "=&r" (tmp),
+	  [status] "=&r" (status)
+	: [mask] "r" (mask),
+	  [val] "r" (val)
+	: "memory"
+	);
+}
+
 #endif /* ATOMICS_H */
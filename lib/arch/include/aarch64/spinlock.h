@@ -6,6 +6,8 @@
 #ifndef SPINLOCK_H
 #define SPINLOCK_H
 
+#include <stdint.h>
+
 /*
  * A trivial spinlock implementation, per ARM DDI 0487D.a, section K11.3.4.
  */
@@ -44,4 +46,122 @@ static inline void spinlock_release(spinlock_t *l)
 	);
 }
 
+/*
+ * Bit lock stored in the bits @mask of the 64-bit word at @loc. The other bits
+ * of the word may be concurrently updated using atomic operations, which
+ * causes the exclusive store to fail and the acquire sequence to be retried.
+ *
+ * Returns the number of times the lock was found held by another CPU, which
+ * is zero if the lock was not contended.
+ */
+static inline unsigned int bitlock_acquire_64(uint64_t *loc, uint64_t mask)
+{
+	uint64_t tmp;
+	unsigned int status, spins;
+
+	asm volatile(
+	"	mov	%w[spins], #0\n"
+	"	sevl\n"
+	"	prfm	pstl1keep, %[loc]\n"
+	"1:\n"
+	"	wfe\n"
+	"	ldaxr	%[tmp], %[loc]\n"
+	"	tst	%[tmp], %[mask]\n"
+	"	b.eq	2f\n"
+	"	add	%w[spins], %w[spins], #1\n"
+	"	b	1b\n"
+	"2:\n"
+	"	orr	%[tmp], %[tmp], %[mask]\n"
+	"	stxr	%w[status], %[tmp], %[loc]\n"
+	"	cbnz	%w[status], 1b\n"
+	: [loc] "+Q" (*loc),
+	  [tmp] "=&r" (tmp),
+	  [status] "=&r" (status),
+	  [spins] "=&r" (spins)
+	: [mask] "r" (mask)
+	: "cc", "memory"
+	);
+
+	return spins;
+}
+
+static inline void bitlock_release_64(uint64_t *loc, uint64_t mask)
+{
+	asm volatile(
+	"	stclrl	%[mask], %[loc]\n"
+	: [loc] "+Q" (*loc)
+	: [mask] "r" (mask)
+	: "memory"
+	);
+}
+
+/*
+ * Ticket lock stored in bits [15:0] of the 64-bit word at @loc. Bits [7:0]
+ * hold the ticket being served and bits [15:8] the next ticket to hand out.
+ * The other bits of the word may be concurrently updated using atomic
+ * operations.
+ *
+ * Waiters are served in the order in which they took their ticket, which
+ * makes the lock fair under contention. A CPU takes a ticket with a single
+ * LSE atomic, and waiters then only read the serving byte, which is written
+ * once by the owner on release.
+ *
+ * At most 255 CPUs may wait on the lock at the same time.
+ *
+ * Returns the number of times the lock was found held by another CPU, which
+ * is zero if the lock was not contended.
+ */
+static inline unsigned int ticketlock_acquire_64(uint64_t *loc)
+{
+	uint8_t *serving = (uint8_t *)loc;
+	unsigned int old, ticket, tmp, spins = 0U;
+
+	asm volatile(
+	"	ldaddah	%w[inc], %w[old], %[lock]\n"
+	: [lock] "+Q" (*(uint16_t *)loc),
+	  [old] "=r" (old)
+	: [inc] "r" (1U << 8)
+	: "memory"
+	);
+
+	ticket = (old >> 8) & 0xffU;
+	if (ticket == (old & 0xffU)) {
+		return 0U;
+	}
+
+	asm volatile(
+	"	sevl\n"
+	"1:\n"
+	"	wfe\n"
+	"	ldaxrb	%w[tmp], %[serving]\n"
+	"	add	%w[spins], %w[spins], #1\n"
+	"	cmp	%w[tmp], %w[ticket]\n"
+	"	b.ne	1b\n"
+	: [serving] "+Q" (*serving),
+	  [tmp] "=&r" (tmp),
+	  [spins] "+r" (spins)
+	: [ticket] "r" (ticket)
+	: "cc", "memory"
+	);
+
+	return spins;
+}
+
+static inline void ticketlock_release_64(uint64_t *loc)
+{
+	uint8_t *serving = (uint8_t *)loc;
+	unsigned int tmp;
+
+	/* Only the owner of the lock updates the serving byte */
+	asm volatile(
+	"	ldrb	%w[tmp], %[serving]\n"
+	"	add	%w[tmp], %w[tmp], #1\n"
+	"	stlrb	%w[tmp], %[serving]\n"
+	: [serving] "+Q" (*serving),
+	  [tmp] "=&r" (tmp)
+	:
+	: "memory"
+	);
+}
+
 #endif /* SPINLOCK_H */
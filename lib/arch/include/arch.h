@@ -481,6 +481,19 @@
 #define ID_AA64ISAR0_RNDR_SHIFT			UL(60)
 #define ID_AA64ISAR0_RNDR_MASK			UL(0xF)
 
+/* TLB range and outer shareable maintenance instructions */
+#define ID_AA64ISAR0_TLB_SHIFT			UL(56)
+#define ID_AA64ISAR0_TLB_MASK			UL(0xF)
+#define ID_AA64ISAR0_TLB_RANGE			UL(0x2)
+
+/* Operand of the TLBI by range instructions, for a 4KB translation granule */
+#define TLBI_RANGE_TG_4K			(UL(1) << 46)
+#define TLBI_RANGE_SCALE_SHIFT			UL(44)
+#define TLBI_RANGE_NUM_SHIFT			UL(39)
+#define TLBI_RANGE_NUM_MAX			UL(32)
+#define TLBI_RANGE_SCALE_MAX			UL(3)
+#define TLBI_RANGE_BADDR_MASK			((UL(1) << 37) - UL(1))
+
 /* ID_AA64MMFR1_EL1 definitions */
 #define ID_AA64MMFR1_EL1_VMIDBits_SHIFT		UL(4)
 #define ID_AA64MMFR1_EL1_VMIDBits_MASK		UL(0xf)
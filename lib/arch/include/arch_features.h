@@ -36,6 +36,19 @@ static inline bool is_feat_rng_present(void)
 		ID_AA64ISAR0_RNDR_MASK) != 0UL;
 }
 
+/*
+ * Check if FEAT_TLBIRANGE is implemented
+ * ID_AA64ISAR0_EL1.TLB, bits [59:56]:
+ * 0b0010 Outer Shareable and TLB range maintenance instructions are
+ *	  implemented.
+ * Higher values also imply range maintenance instructions.
+ */
+static inline bool is_feat_tlbirange_present(void)
+{
+	return ((read_ID_AA64ISAR0_EL1() >> ID_AA64ISAR0_TLB_SHIFT) &
+		ID_AA64ISAR0_TLB_MASK) >= ID_AA64ISAR0_TLB_RANGE;
+}
+
 /*
  * Check if FEAT_VMID16 is implemented
  * ID_AA64MMFR1_EL1.VMIDBits, bits [7:4]:
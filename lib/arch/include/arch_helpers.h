@@ -45,12 +45,14 @@ DEFINE_SYSOP_TYPE_FUNC(tlbi, alle2is)
 DEFINE_SYSOP_TYPE_FUNC(tlbi, vmalle1)
 DEFINE_SYSOP_TYPE_FUNC(tlbi, vmalle1is)
 DEFINE_SYSOP_TYPE_FUNC(tlbi, vmalls12e1)
+DEFINE_SYSOP_TYPE_FUNC(tlbi, vmalls12e1is)
 
 DEFINE_SYSOP_TYPE_PARAM_FUNC(tlbi, vaae1is)
 DEFINE_SYSOP_TYPE_PARAM_FUNC(tlbi, vaale1is)
 DEFINE_SYSOP_TYPE_PARAM_FUNC(tlbi, vae2is)
 DEFINE_SYSOP_TYPE_PARAM_FUNC(tlbi, vale2is)
 DEFINE_SYSOP_TYPE_PARAM_FUNC(tlbi, ipas2e1is)
+DEFINE_SYSOP_TYPE_PARAM_FUNC(tlbi, ripas2e1is)
 
 /*******************************************************************************
  * Cache maintenance accessor prototypes
@@ -320,6 +322,7 @@ DEFINE_SYSREG_RW_FUNCS(cntp_ctl_el0)
 DEFINE_SYSREG_RW_FUNCS(cntp_tval_el0)
 DEFINE_SYSREG_RW_FUNCS(cntp_cval_el0)
 DEFINE_SYSREG_READ_FUNC(cntpct_el0)
+DEFINE_SYSREG_READ_FUNC(cntvct_el0)
 DEFINE_SYSREG_RW_FUNCS(cnthctl_el2)
 DEFINE_SYSREG_RW_FUNCS(cntp_ctl_el02)
 DEFINE_SYSREG_RW_FUNCS(cntp_cval_el02)
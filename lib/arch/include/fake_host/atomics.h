@@ -75,4 +75,14 @@ static inline bool atomic_bit_set_acquire_release_64(uint64_t *loc, int bit)
 	return (old_val != 0UL);
 }
 
+/*
+ * Atomically replace the bits @mask of the 64-bit value stored at memory
+ * location @loc with @val. @val must not have any bit set outside of @mask.
+ */
+static inline void atomic_bits_write_64(uint64_t *loc, uint64_t mask,
+					uint64_t val)
+{
+	*loc = (*loc & ~mask) | val;
+}
+
 #endif /* ATOMICS_H */
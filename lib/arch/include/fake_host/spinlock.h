@@ -7,6 +7,7 @@
 #define SPINLOCK_H
 
 #include <host_harness.h>
+#include <stdint.h>
 
 typedef struct spinlock_s {
 	unsigned int val;
@@ -22,4 +23,31 @@ static inline void spinlock_release(spinlock_t *l)
 	host_spinlock_release(l);
 }
 
+static inline unsigned int bitlock_acquire_64(uint64_t *loc, uint64_t mask)
+{
+	unsigned int spins = ((*loc & mask) != 0UL) ? 1U : 0U;
+
+	*loc |= mask;
+	return spins;
+}
+
+static inline void bitlock_release_64(uint64_t *loc, uint64_t mask)
+{
+	*loc &= ~mask;
+}
+
+static inline unsigned int ticketlock_acquire_64(uint64_t *loc)
+{
+	uint64_t serving = *loc & 0xffUL;
+	uint64_t ticket = (*loc >> 8) & 0xffUL;
+
+	*loc = (*loc & ~0xff00UL) | (((ticket + 1UL) & 0xffUL) << 8);
+	return (ticket != serving) ? 1U : 0U;
+}
+
+static inline void ticketlock_release_64(uint64_t *loc)
+{
+	*loc = (*loc & ~0xffUL) | ((*loc + 1UL) & 0xffUL);
+}
+
 #endif /* SPINLOCK_H */
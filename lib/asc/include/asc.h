@@ -5,10 +5,58 @@
 #ifndef ASC_H
 #define ASC_H
 
+#include <sizes.h>
+#include <stdbool.h>
+
+/* Operations supported by asc_mark_batch() */
+#define ASC_BATCH_MARK_SECURE		(0UL)
+#define ASC_BATCH_MARK_NONSECURE	(1UL)
+#define ASC_BATCH_MARK_SECURE_DEV	(2UL)
+
+/* Status of an entry which has not been processed by EL3 */
+#define ASC_BATCH_STATUS_NOT_DONE	(~0UL)
+
+/*
+ * Entry of a batched ASC request, passed to EL3 through the RMM-EL3 shared
+ * buffer. @iova is only used by ASC_BATCH_MARK_SECURE_DEV.
+ *
+ * EL3 processes the entries in order and stops at the first entry which it
+ * fails to transition. It writes the status of each processed entry to
+ * @status, which is zero on success.
+ */
+struct asc_batch_entry {
+	unsigned long addr;
+	unsigned long iova;
+	unsigned long status;
+};
+
+/* Maximum number of entries which fit in the RMM-EL3 shared buffer */
+#define ASC_BATCH_MAX_ENTRIES	\
+	(unsigned int)(SZ_4K / sizeof(struct asc_batch_entry))
+
+/*
+ * SMMUv3 command, as written by EL3 to the command queue of the SMMU which
+ * translates the StreamID it applies to.
+ */
+struct asc_smmu_cmd {
+	unsigned long dw0;
+	unsigned long dw1;
+};
+
+/* Maximum number of SMMU commands which fit in the RMM-EL3 shared buffer */
+#define ASC_SMMU_CMD_MAX_ENTRIES	\
+	(unsigned int)(SZ_4K / sizeof(struct asc_smmu_cmd))
+
 void asc_mark_secure(unsigned long addr);
 void asc_mark_nonsecure(unsigned long addr);
 void asc_mark_secure_dev(unsigned long addr, unsigned long delegate_flag, unsigned long iova);
-void asc_add_translation_table(unsigned long phys_addr,unsigned long iova, unsigned int sid);
 void asc_attach_dev(unsigned long addr);
+unsigned int asc_mark_batch(unsigned long op, unsigned long delegate_flag,
+			    struct asc_batch_entry *entries,
+			    unsigned int count);
+unsigned long asc_smmu_s2_attach(unsigned int sid, unsigned long root_pa,
+				 unsigned int vmid, unsigned int ipa_bits);
+void asc_smmu_s2_detach(unsigned int sid);
+bool asc_smmu_cmd_batch(struct asc_smmu_cmd *cmds, unsigned int count);
 
 #endif /* ASC_H */
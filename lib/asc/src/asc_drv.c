@@ -3,7 +3,9 @@
  * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
  */
 
+#include <asc.h>
 #include <assert.h>
+#include <rmm_el3_ifc.h>
 #include <smc.h>
 
 void asc_mark_secure(unsigned long addr)
@@ -37,3 +39,102 @@ void asc_attach_dev(unsigned long addr)
 	ret = monitor_call(SMC_ASC_ATTACH_DEV, addr, 0, 0, 0, 0, 0);
 	assert(ret == 0);
 }
+
+/*
+ * Transition the @count granules described by @entries with a single call to
+ * EL3, using the RMM-EL3 shared buffer to pass the entries. @op is one of
+ * ASC_BATCH_MARK_*. The status of each entry is written back to @entries.
+ *
+ * Returns the number of entries which were successfully transitioned. As EL3
+ * stops at the first failure, these are always the first entries of the batch.
+ */
+unsigned int asc_mark_batch(unsigned long op, unsigned long delegate_flag,
+			    struct asc_batch_entry *entries,
+			    unsigned int count)
+{
+	struct asc_batch_entry *buf;
+	unsigned long ret;
+	unsigned int i, done = count;
+
+	assert(count <= ASC_BATCH_MAX_ENTRIES);
+
+	buf = (struct asc_batch_entry *)rmm_el3_ifc_get_shared_buf_locked();
+
+	for (i = 0U; i < count; i++) {
+		buf[i].addr = entries[i].addr;
+		buf[i].iova = entries[i].iova;
+		buf[i].status = ASC_BATCH_STATUS_NOT_DONE;
+	}
+
+	ret = monitor_call(SMC_ASC_MARK_BATCH, op,
+			   (unsigned long)rmm_el3_ifc_get_shared_buf_pa(),
+			   count, delegate_flag, 0, 0);
+
+	/*
+	 * A zero return value means that all the entries have been
+	 * transitioned, otherwise the status of each entry is read back.
+	 */
+	for (i = 0U; i < count; i++) {
+		entries[i].status = (ret == 0UL) ? 0UL : buf[i].status;
+		if ((entries[i].status != 0UL) && (done == count)) {
+			done = i;
+		}
+	}
+
+	rmm_el3_ifc_release_shared_buf();
+
+	return done;
+}
+
+/*
+ * Ask EL3 to point the stage 2 translation of StreamID @sid to the tables
+ * rooted at @root_pa, which translate an IPA space of @ipa_bits bits using the
+ * stage 2 format of the CPU, with VMID @vmid.
+ *
+ * Returns zero on success, or the error returned by EL3 if the StreamID
+ * cannot be used by the RMM.
+ */
+unsigned long asc_smmu_s2_attach(unsigned int sid, unsigned long root_pa,
+				 unsigned int vmid, unsigned int ipa_bits)
+{
+	return monitor_call(SMC_ASC_SMMU_S2_ATTACH, sid, root_pa, vmid,
+			    ipa_bits, 0, 0);
+}
+
+void asc_smmu_s2_detach(unsigned int sid)
+{
+	__unused int ret;
+
+	ret = monitor_call(SMC_ASC_SMMU_S2_DETACH, sid, 0, 0, 0, 0, 0);
+	assert(ret == 0);
+}
+
+/*
+ * Pass the @count SMMU commands of @cmds to EL3 with a single call, using the
+ * RMM-EL3 shared buffer. EL3 writes them to the command queue in order and
+ * waits for the completion of the last one, which is expected to be a
+ * CMD_SYNC.
+ *
+ * Returns true if all the commands have been consumed by the SMMU.
+ */
+bool asc_smmu_cmd_batch(struct asc_smmu_cmd *cmds, unsigned int count)
+{
+	struct asc_smmu_cmd *buf;
+	unsigned long ret;
+
+	assert(count <= ASC_SMMU_CMD_MAX_ENTRIES);
+
+	buf = (struct asc_smmu_cmd *)rmm_el3_ifc_get_shared_buf_locked();
+
+	for (unsigned int i = 0U; i < count; i++) {
+		buf[i] = cmds[i];
+	}
+
+	ret = monitor_call(SMC_ASC_SMMU_CMD_BATCH,
+			   (unsigned long)rmm_el3_ifc_get_shared_buf_pa(),
+			   count, 0, 0, 0, 0);
+
+	rmm_el3_ifc_release_shared_buf();
+
+	return (ret == 0UL);
+}
@@ -91,4 +91,18 @@ void *host_buffer_arch_map(enum buffer_slot slot,
  */
 void host_buffer_arch_unmap(void *buf);
 
+/*
+ * Fake host wrapper to map @num_granules contiguous granules starting at PA
+ * @addr in the slot window.
+ *
+ * It returns the VA to which the window is mapped.
+ */
+void *host_buffer_arch_map_window(unsigned long addr,
+				  unsigned long num_granules, bool ns);
+
+/*
+ * Fake host wrapper to unmap the slot window mapped at `buf`.
+ */
+void host_buffer_arch_unmap_window(void *buf, unsigned long num_granules);
+
 #endif /* HOST_HARNESS_H */
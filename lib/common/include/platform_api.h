@@ -10,6 +10,31 @@
 void plat_warmboot_setup(uint64_t x0, uint64_t x1, uint64_t x2, uint64_t x3);
 void plat_setup(uint64_t x0, uint64_t x1, uint64_t x2, uint64_t x3);
 
+/* Maximum number of DRAM banks covered by the struct granules array */
+#define PLAT_MAX_DRAM_BANKS	8U
+
+/* Description of a DRAM bank for the granule indexing layer */
+struct plat_dram_bank {
+	unsigned long base;	/* Base address, granule aligned */
+	unsigned long size;	/* Size in bytes, granule aligned */
+};
+
+/*
+ * Setup the mapping between the granule addresses and the indexes in the
+ * struct granules array. @banks describes @num_banks DRAM banks, sorted by
+ * increasing base address and not overlapping. Each bank is mapped to a
+ * compact range of indexes, so that the struct granules array only covers
+ * the memory which exists on the platform.
+ *
+ * If the banks contain more than RMM_MAX_GRANULES granules, only the first
+ * RMM_MAX_GRANULES granules are covered.
+ *
+ * This function must be called once during cold boot, before any granule
+ * lookup. Returns 0 on success or a negative error code otherwise.
+ */
+int plat_granule_banks_init(const struct plat_dram_bank *banks,
+			    unsigned long num_banks);
+
 /*
  * Takes an aligned granule address, validates it and if valid returns the
  * index in the struct granules array or UINT64_MAX in case of an error.
@@ -75,6 +75,21 @@ CCA_MARKER(0x200); \
 #define smc_rec_aux_count_cca_marker() CCA_MARKER(0x145)
 #define smc_rtt_init_ripas_cca_marker() CCA_MARKER(0x146)
 #define smc_rtt_set_ripas_cca_marker() CCA_MARKER(0x147)
+#define smc_granule_delegate_range_cca_marker() CCA_MARKER(0x148)
+#define smc_granule_undelegate_range_cca_marker() CCA_MARKER(0x149)
+#define smc_granule_lock_stats_cca_marker() CCA_MARKER(0x14A)
+#define smc_data_create_range_cca_marker() CCA_MARKER(0x14B)
+#define smc_rtt_init_ripas_range_cca_marker() CCA_MARKER(0x14C)
+#define smc_rtt_fold_query_cca_marker() CCA_MARKER(0x14D)
+#define smc_rtt_teardown_cca_marker() CCA_MARKER(0x14E)
+#define smc_rtt_read_entries_cca_marker() CCA_MARKER(0x14F)
+#define smc_smmu_stream_create_cca_marker() CCA_MARKER(0x150)
+#define smc_smmu_stream_destroy_cca_marker() CCA_MARKER(0x151)
+#define smc_smmu_table_add_cca_marker() CCA_MARKER(0x152)
+#define smc_smmu_map_cca_marker() CCA_MARKER(0x153)
+#define smc_smmu_unmap_cca_marker() CCA_MARKER(0x154)
+#define smc_dev_create_cca_marker() CCA_MARKER(0x155)
+#define smc_dev_destroy_cca_marker() CCA_MARKER(0x156)
 
 #ifdef MICRO_BENCH
 #define RMI_REALM_CREATE_START() CCA_MARKER(0x1040)
@@ -83,9 +98,15 @@ CCA_MARKER(0x200); \
 //TODO : Not used now. Add it later for single benchmark. 
 #define RSI_DEL_DEV_MEM_START() CCA_MARKER(0x1041)
 #define RSI_DEL_DEV_MEM_STOP() CCA_MARKER(0x1041)
+
+/* Uniformity scan of an RTT, used by RTT_FOLD and RTT_DESTROY */
+#define RTT_TABLE_SCAN_START() CCA_MARKER(0x1042)
+#define RTT_TABLE_SCAN_STOP() CCA_MARKER(0x1043)
 #else
 #define RMI_REALM_CREATE_START() 
 #define RMI_REALM_CREATE_STOP() 
+#define RTT_TABLE_SCAN_START()
+#define RTT_TABLE_SCAN_STOP()
 #endif
 
 #endif
@@ -33,15 +33,32 @@ enum buffer_slot {
 	SLOT_RTT = SLOT_REC_AUX0 + MAX_REC_AUX_GRANULES,
 	SLOT_RTT2,		/* Some commands access two RTT granules at a time*/
 	SLOT_RSI_CALL,
+	SLOT_RTT_L0,		/* RTT walk slots, one per RTT level, so that
+				 * the tables of consecutive walks stay mapped.
+				 */
+	SLOT_RTT_L1,
+	SLOT_RTT_L2,
+	SLOT_RTT_L3,
+	SLOT_DEV,
 	NR_CPU_SLOTS
 };
 
+/*
+ * Maximum number of physically contiguous granules which can be mapped at
+ * once in the slot window.
+ */
+#define SLOT_WINDOW_MAX_GRANULES	U(256)
+
 struct granule;
 
 void assert_cpu_slots_empty(void);
 void *granule_map(struct granule *g, enum buffer_slot slot);
 void buffer_unmap(void *buf);
 
+void *buffer_map_window(unsigned long addr, unsigned long num_granules,
+			bool ns);
+void buffer_unmap_window(void *buf);
+
 bool ns_buffer_read(enum buffer_slot slot,
 		    struct granule *granule,
 		    unsigned int offset,
@@ -88,4 +105,18 @@ void *buffer_map_internal(enum buffer_slot slot, unsigned long addr, bool ns);
  */
 void buffer_unmap_internal(void *buf);
 
+/*
+ * Maps @num_granules physically contiguous granules starting at @addr in the
+ * slot window.
+ *
+ * On success, it returns the VA of the window. Otherwise, it will return NULL.
+ */
+void *buffer_map_window_internal(unsigned long addr,
+				 unsigned long num_granules, bool ns);
+
+/*
+ * Unmaps the @num_granules granules mapped in the slot window at `buf`.
+ */
+void buffer_unmap_window_internal(void *buf, unsigned long num_granules);
+
 #endif /* BUFFER_H */
@@ -0,0 +1,59 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#ifndef DEV_H
+#define DEV_H
+
+#include <stdbool.h>
+#include <utils_def.h>
+
+/* Number of BARs of a PCIe type 0 function */
+#define DEV_MAX_BARS		6U
+
+/*
+ * Number of entries of the device registry, indexed by StreamID. It is kept
+ * at most half full so that the probe sequences stay short.
+ */
+#define DEV_INDEX_BITS		6U
+#define DEV_INDEX_SIZE		(1U << DEV_INDEX_BITS)
+#define DEV_MAX_DEVS		(DEV_INDEX_SIZE / 2U)
+
+/*
+ * Device memory range of a BAR, as mapped in the IPA space of the realm. The
+ * size is rounded up to a whole number of granules.
+ */
+struct dev_bar {
+	unsigned long ipa;
+	unsigned long pa;
+	unsigned long size;
+};
+
+/*
+ * Descriptor of a device assigned to a realm, stored in a granule in the DEV
+ * state. The BARs are recorded when the device is attached.
+ */
+struct dev_desc {
+	unsigned int sid;
+	unsigned int vmid;
+	bool attached;
+	unsigned int nr_bars;
+	struct dev_bar bars[DEV_MAX_BARS];
+};
+COMPILER_ASSERT(sizeof(struct dev_desc) <= GRANULE_SIZE);
+
+struct granule;
+struct rd;
+
+unsigned long dev_create(unsigned int sid, struct granule *g_rd,
+			 struct rd *rd, struct granule *g_dev);
+unsigned long dev_destroy(unsigned int sid, struct granule *g_rd,
+			  struct rd *rd);
+unsigned long dev_attach(unsigned int sid, struct granule *g_rd,
+			 const struct dev_bar *bars, unsigned int nr_bars);
+bool dev_lookup(unsigned int sid, struct granule *g_rd,
+		unsigned int *vmid, bool *attached);
+bool dev_pa_range_owned(struct rd *rd, unsigned long pa, unsigned long size);
+
+#endif /* DEV_H */
@@ -13,21 +13,97 @@
 #include <memory.h>
 #include <spinlock.h>
 #include <status.h>
+
+struct asc_batch_entry;
+
 /*
 *The caller should hold a lock on the granule
 */
-unsigned long smc_granule_delegate_dev(unsigned long addr, unsigned long delegate_flag, unsigned long iova);
+unsigned int smc_granule_delegate_dev(struct asc_batch_entry *entries,
+				      unsigned int count,
+				      unsigned long delegate_flag);
 unsigned long smc_add_page_to_smmu_tables(unsigned long phys_addr, unsigned long iova, unsigned int sid);
 unsigned long smc_attach_dev(unsigned long addr);
 
+void granule_lock_contended(enum granule_state lock_class);
+unsigned long granule_lock_contention_count(enum granule_state lock_class);
+
+struct rmi_lock_stats;
+
+#ifdef RMM_GRANULE_LOCK_STATS
+void granule_lock_stats_acquired(struct granule *g,
+				 enum granule_state lock_class,
+				 unsigned int spins);
+void granule_lock_stats_released(struct granule *g);
+bool granule_lock_stats_read(unsigned int cpu_id,
+			     struct rmi_lock_stats *stats);
+void granule_lock_stats_dump(void);
+#else
+static inline void granule_lock_stats_acquired(struct granule *g,
+					       enum granule_state lock_class,
+					       unsigned int spins)
+{
+	(void)g;
+	(void)lock_class;
+	(void)spins;
+}
+
+static inline void granule_lock_stats_released(struct granule *g)
+{
+	(void)g;
+}
+
+static inline bool granule_lock_stats_read(unsigned int cpu_id,
+					   struct rmi_lock_stats *stats)
+{
+	(void)cpu_id;
+	(void)stats;
+	return false;
+}
+
+static inline void granule_lock_stats_dump(void)
+{
+}
+#endif /* RMM_GRANULE_LOCK_STATS */
+
 static inline unsigned long granule_refcount_read_relaxed(struct granule *g)
 {
-	return __sca_read64(&g->refcount);
+	return EXTRACT(GRN_REFCOUNT, __sca_read64(&g->descriptor));
 }
 
 static inline unsigned long granule_refcount_read_acquire(struct granule *g)
 {
-	return __sca_read64_acquire(&g->refcount);
+	return EXTRACT(GRN_REFCOUNT, __sca_read64_acquire(&g->descriptor));
+}
+
+/* Must be called with g->lock held */
+static inline unsigned long granule_refcount_read(struct granule *g)
+{
+	return granule_refcount_read_relaxed(g);
+}
+
+/*
+ * Returns true if the content of the granule has not been zeroed since it was
+ * delegated. Must be called with g->lock held.
+ */
+static inline bool granule_needs_scrub(struct granule *g)
+{
+	return (__sca_read64(&g->descriptor) & GRN_SCRUB_BIT) != 0UL;
+}
+
+/* Must be called with g->lock held */
+static inline void granule_set_needs_scrub(struct granule *g)
+{
+	atomic_bits_write_64(&g->descriptor, GRN_SCRUB_BIT, GRN_SCRUB_BIT);
+}
+
+/*
+ * Must be called with g->lock held, once the content of the granule has been
+ * zeroed or fully overwritten.
+ */
+static inline void granule_clear_needs_scrub(struct granule *g)
+{
+	atomic_bits_write_64(&g->descriptor, GRN_SCRUB_BIT, 0UL);
 }
 
 /*
@@ -44,12 +120,14 @@ static inline unsigned long granule_refcount_read_acquire(struct granule *g)
 static inline void __granule_assert_unlocked_invariants(struct granule *g,
 							enum granule_state state)
 {
+	assert((state == GRANULE_STATE_DELEGATED) || !granule_needs_scrub(g));
+
 	switch (state) {
 	case GRANULE_STATE_NS:
 		assert(granule_refcount_read_relaxed(g) == 0UL);
 		break;
 	case GRANULE_STATE_DELEGATED:
-		assert(g->refcount == 0UL);
+		assert(granule_refcount_read_relaxed(g) == 0UL);
 		break;
 	case GRANULE_STATE_RD:
 		/*
@@ -62,13 +140,16 @@ static inline void __granule_assert_unlocked_invariants(struct granule *g,
 		assert(granule_refcount_read_relaxed(g) <= 1UL);
 		break;
 	case GRANULE_STATE_DATA:
-		assert(g->refcount == 0UL);
+		assert(granule_refcount_read_relaxed(g) == 0UL);
 		break;
 	case GRANULE_STATE_RTT:
-		assert(g->refcount >= 0UL);
+		/* Can be any non-negative number */
 		break;
 	case GRANULE_STATE_REC_AUX:
-		assert(g->refcount == 0UL);
+		assert(granule_refcount_read_relaxed(g) == 0UL);
+		break;
+	case GRANULE_STATE_DEV:
+		assert(granule_refcount_read_relaxed(g) == 0UL);
 		break;
 	default:
 		/* Unknown granule type */
@@ -79,14 +160,64 @@ static inline void __granule_assert_unlocked_invariants(struct granule *g,
 /* Must be called with g->lock held */
 static inline enum granule_state granule_get_state(struct granule *g)
 {
-	return g->state;
+	return (enum granule_state)EXTRACT(GRN_STATE,
+					   __sca_read64(&g->descriptor));
+}
+
+/*
+ * Returns the state of a granule which is not locked by the caller. The state
+ * may be changed concurrently, so the returned value can only be used as a
+ * hint, e.g. to reject an invalid address early.
+ */
+static inline enum granule_state granule_unlocked_state(struct granule *g)
+{
+	return granule_get_state(g);
 }
 
 /* Must be called with g->lock held */
 static inline void granule_set_state(struct granule *g,
 				     enum granule_state state)
 {
-	g->state = state;
+	atomic_bits_write_64(&g->descriptor, MASK(GRN_STATE),
+			     INPLACE(GRN_STATE, state));
+}
+
+/*
+ * The granule lock is either a bit lock or, when RMM_GRANULE_TICKET_LOCK is
+ * defined, a fair ticket lock. Both are stored in the lock field of
+ * g->descriptor.
+ *
+ * Contention is accounted to the lock class, which is the state the caller
+ * expects the granule to be in. With RMM_GRANULE_LOCK_STATS, the acquisitions,
+ * spin iterations and hold times are also recorded per lock class and per CPU.
+ */
+static inline void __granule_lock_acquire(struct granule *g,
+					  enum granule_state expected_state)
+{
+	unsigned int spins;
+
+#ifdef RMM_GRANULE_TICKET_LOCK
+	spins = ticketlock_acquire_64(&g->descriptor);
+#else
+	spins = bitlock_acquire_64(&g->descriptor, GRN_LOCK_BIT);
+#endif
+
+	if (spins != 0U) {
+		granule_lock_contended(expected_state);
+	}
+
+	granule_lock_stats_acquired(g, expected_state, spins);
+}
+
+static inline void __granule_lock_release(struct granule *g)
+{
+	granule_lock_stats_released(g);
+
+#ifdef RMM_GRANULE_TICKET_LOCK
+	ticketlock_release_64(&g->descriptor);
+#else
+	bitlock_release_64(&g->descriptor, GRN_LOCK_BIT);
+#endif
 }
 
 /*
@@ -97,10 +228,10 @@ static inline void granule_set_state(struct granule *g,
 static inline bool granule_lock_on_state_match(struct granule *g,
 				    enum granule_state expected_state)
 {
-	spinlock_acquire(&g->lock);
+	__granule_lock_acquire(g, expected_state);
 
 	if (granule_get_state(g) != expected_state) {
-		spinlock_release(&g->lock);
+		__granule_lock_release(g);
 		return false;
 	}
 
@@ -123,7 +254,7 @@ static inline void granule_lock(struct granule *g,
 static inline void granule_unlock(struct granule *g)
 {
 	__granule_assert_unlocked_invariants(g, granule_get_state(g));
-	spinlock_release(&g->lock);
+	__granule_lock_release(g);
 }
 
 /* Transtion state to @new_state and unlock the granule */
@@ -140,6 +271,23 @@ struct granule *find_granule(unsigned long addr);
 struct granule *find_lock_granule(unsigned long addr,
 				  enum granule_state expected_state);
 
+/*
+ * Granule to be locked as part of a set by find_lock_granules().
+ */
+struct granule_set {
+	/* Position of the item in the set before it is sorted */
+	unsigned int idx;
+	/* Address and expected state of the granule */
+	unsigned long addr;
+	enum granule_state state;
+	/* Locked granule */
+	struct granule *g;
+	/* Optional location where the locked granule is returned */
+	struct granule **g_ret;
+};
+
+bool find_lock_granules(struct granule_set *granules, unsigned long n);
+void granule_unlock_set(struct granule_set *granules, unsigned long n);
 bool find_lock_two_granules(unsigned long addr1,
 			    enum granule_state expected_state1,
 			    struct granule **g1,
@@ -151,30 +299,34 @@ void granule_memzero(struct granule *g, enum buffer_slot slot);
 
 void granule_memzero_mapped(void *buf);
 
+void granule_scrub_on_use(struct granule *g, enum buffer_slot slot);
+
+void granule_scrub_mapped_on_use(struct granule *g, void *buf);
+
 /* Must be called with g->lock held */
 static inline void __granule_get(struct granule *g)
 {
-	g->refcount++;
+	atomic_add_64(&g->descriptor, (long)INPLACE(GRN_REFCOUNT, 1UL));
 }
 
 /* Must be called with g->lock held */
 static inline void __granule_put(struct granule *g)
 {
-	assert(g->refcount > 0UL);
-	g->refcount--;
+	assert(granule_refcount_read(g) > 0UL);
+	atomic_add_64(&g->descriptor, -(long)INPLACE(GRN_REFCOUNT, 1UL));
 }
 
 /* Must be called with g->lock held */
 static inline void __granule_refcount_inc(struct granule *g, unsigned long val)
 {
-	g->refcount += val;
+	atomic_add_64(&g->descriptor, (long)INPLACE(GRN_REFCOUNT, val));
 }
 
 /* Must be called with g->lock held */
 static inline void __granule_refcount_dec(struct granule *g, unsigned long val)
 {
-	assert(g->refcount >= val);
-	g->refcount -= val;
+	assert(granule_refcount_read(g) >= val);
+	atomic_add_64(&g->descriptor, -(long)INPLACE(GRN_REFCOUNT, val));
 }
 
 /*
@@ -182,7 +334,7 @@ static inline void __granule_refcount_dec(struct granule *g, unsigned long val)
  */
 static inline void atomic_granule_get(struct granule *g)
 {
-	atomic_add_64(&g->refcount, 1UL);
+	atomic_add_64(&g->descriptor, (long)INPLACE(GRN_REFCOUNT, 1UL));
 }
 
 /*
@@ -190,7 +342,7 @@ static inline void atomic_granule_get(struct granule *g)
  */
 static inline void atomic_granule_put(struct granule *g)
 {
-	atomic_add_64(&g->refcount, -1L);
+	atomic_add_64(&g->descriptor, -(long)INPLACE(GRN_REFCOUNT, 1UL));
 }
 
 /*
@@ -199,10 +351,11 @@ static inline void atomic_granule_put(struct granule *g)
  */
 static inline void atomic_granule_put_release(struct granule *g)
 {
-	unsigned long old_refcount __unused;
+	unsigned long old_desc __unused;
 
-	old_refcount = atomic_load_add_release_64(&g->refcount, -1L);
-	assert(old_refcount > 0UL);
+	old_desc = atomic_load_add_release_64(&g->descriptor,
+					      -(long)INPLACE(GRN_REFCOUNT, 1UL));
+	assert(EXTRACT(GRN_REFCOUNT, old_desc) > 0UL);
 }
 
 /*
@@ -6,7 +6,8 @@
 #ifndef GRANULE_TYPES_H
 #define GRANULE_TYPES_H
 
-#include <spinlock.h>
+#include <stdint.h>
+#include <utils_def.h>
 
 /*
  * Locking Order
@@ -34,6 +35,7 @@
  * - GRANULE_STATE_RTT
  * - GRANULE_STATE_DATA
  * - GRANULE_STATE_REC_AUX
+ * - GRANULE_STATE_DEV
  *
  * The following locking rules must be followed in all cases:
  *
@@ -51,6 +53,7 @@
  *    1. `RTT`
  *    2. `DATA`
  *    3. `REC_AUX`
+ *    4. `DEV`
  *
  * 5. Granules in the same `internal` state must be locked in the order defined
  *    below for that specific state.
@@ -61,8 +64,15 @@
  * ----------
  * GRANULE_STATE_DELEGATED is special, in that it is the gateway between the
  * non-secure and realm world.  We maintain the property that any unlocked
- * granule with state == GRANULE_STATE_DELEGATED contains only zeroes; while
- * locked these may contain non-zero values.
+ * granule with state == GRANULE_STATE_DELEGATED contains only zeroes, unless
+ * GRN_SCRUB_BIT is set in its descriptor; while locked these may contain
+ * non-zero values.
+ *
+ * GRN_SCRUB_BIT is set when a granule is delegated, instead of zeroing it
+ * immediately. Such a granule only contains data written by the NS world
+ * before it was delegated, and it is zeroed (or fully overwritten) when it
+ * first leaves the DELEGATED state for a realm state. GRN_SCRUB_BIT is never
+ * set for a granule which is not in the DELEGATED state.
  */
 
 enum granule_state {
@@ -183,36 +193,74 @@ enum granule_state {
 	 *   - Valid_NS s2tte.
 	 *   - Assigned s2tte.
 	 */
-	GRANULE_STATE_RTT
-};
-
-struct granule {
+	GRANULE_STATE_RTT,
 	/*
-	 * @lock protects the struct granule itself. Take this lock whenever
-	 * inspecting or modifying any other fields in this struct.
+	 * Device descriptor Granule (internal)
+	 *
+	 * Granule content is protected by granule::lock.
+	 *
+	 * A granule in this state describes a device assigned to a Realm and
+	 * is referenced from the RD of that Realm and from the device
+	 * registry. It must be locked after the RD and while no other
+	 * `internal` granule is locked:
+	 *
+	 * RD -> DEV
+	 *
+	 * No references are held on this granule type.
 	 */
-	spinlock_t lock;
+	GRANULE_STATE_DEV
+};
 
-	/*
-	 * @state is the state of the granule.
-	 */
-	enum granule_state state;
+/*
+ * Granule locks are grouped in classes for accounting purposes. The class of a
+ * lock is the state the caller expects the granule to be in.
+ */
+#define GRANULE_LOCK_CLASSES	((unsigned int)GRANULE_STATE_DEV + 1U)
+
+/*
+ * Layout of struct granule::descriptor:
+ *
+ * [15:0]  - Lock. Only GRN_LOCK_BIT is used by the default bit lock. With
+ *           RMM_GRANULE_TICKET_LOCK, [7:0] hold the ticket being served and
+ *           [15:8] the next ticket.
+ * [23:16] - State of the granule (enum granule_state).
+ * [24]    - Scrub bit. The granule needs to be zeroed before its first use.
+ * [31:25] - Reserved.
+ * [63:32] - Reference count.
+ */
+#define GRN_LOCK_BIT		(UL(1) << 0)
+
+#define GRN_STATE_SHIFT		UL(16)
+#define GRN_STATE_WIDTH		UL(8)
 
+#define GRN_SCRUB_BIT		(UL(1) << 24)
+
+#define GRN_REFCOUNT_SHIFT	UL(32)
+#define GRN_REFCOUNT_WIDTH	UL(32)
+
+struct granule {
 	/*
-	 * @refcount counts RMM and realm references to this granule with the
-	 * following rules:
-	 *  - The @state of the granule cannot be modified when @refcount
-	 *    is non-zero.
+	 * @descriptor packs the lock, the state and the reference count of
+	 * the granule into a single 64-bit word.
+	 *
+	 * The lock protects the struct granule itself. Take this lock whenever
+	 * inspecting or modifying the state of the granule.
+	 *
+	 * The reference count counts RMM and realm references to this granule
+	 * with the following rules:
+	 *  - The state of the granule cannot be modified when the reference
+	 *    count is non-zero.
 	 *  - When a granule is mapped into the RMM, either the granule lock
 	 *    must be held or a reference must be held.
-	 *  - The content of the granule itself can be modified when
-	 *    @refcount is non-zero without holding @lock.  However, specific
-	 *    types of granules may impose further restrictions on concurrent
-	 *    access.
+	 *  - The content of the granule itself can be modified when the
+	 *    reference count is non-zero without holding the lock. However,
+	 *    specific types of granules may impose further restrictions on
+	 *    concurrent access.
+	 *
+	 * As the reference count can be updated without holding the lock,
+	 * all the updates to @descriptor are done with atomic operations.
 	 */
-	unsigned long refcount;
-	//TODO[Supraja] : if we decide to remove per-core GPT and GPT change on context switches this is not required anymore. 
-	bool nsp;
+	uint64_t descriptor;
 };
 
 #endif /* GRANULE_TYPES_H */
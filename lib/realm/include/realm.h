@@ -16,6 +16,9 @@
 #define REALM_STATE_ACTIVE	1
 #define REALM_STATE_SYSTEM_OFF	2
 
+/* Maximum number of devices assigned to a Realm */
+#define REALM_MAX_DEVS		4U
+
 /*
  * Stage 2 configuration of the Realm
  */
@@ -40,6 +43,45 @@ struct realm_s2_context {
 	 */
 };
 
+/*
+ * Last level table reached by the latest walk done through
+ * rtt_walk_lock_unlock_cached(). The entry is only valid while @gen matches
+ * rd::rtt_gen.
+ */
+struct rtt_walk_cache {
+	/* Value of rd::rtt_gen when the entry was filled */
+	unsigned long gen;
+
+	/* Base of the IPA range translated by @g_tbl */
+	unsigned long ipa;
+
+	/* RTT level of @g_tbl */
+	long level;
+
+	/* Cached RTT granule, NULL if the entry is empty */
+	struct granule *g_tbl;
+};
+
+/* Number of RTT fold events which can be queued in the RD */
+#define RTT_FOLD_EVENTS		16U
+
+/*
+ * RTT which became foldable, reported to the Host by RMI_RTT_FOLD_QUERY.
+ */
+struct rtt_fold_event {
+	/* RMI_RTT_FOLD_EVENT_* */
+	unsigned long type;
+
+	/* Base of the IPA range translated by the RTT */
+	unsigned long ipa;
+
+	/* RTT level */
+	long level;
+
+	/* RTT address */
+	unsigned long rtt_addr;
+};
+
 /* struct rd is protected by the rd granule lock */
 struct rd {
 	/*
@@ -66,6 +108,41 @@ struct rd {
 	/* Stage 2 configuration of the Realm */
 	struct realm_s2_context s2_ctx;
 
+	/*
+	 * RTT generation. It is incremented by rtt_remove_begin() and
+	 * rtt_remove_end() around the removal of an RTT from the RTT tree, by
+	 * RTT_DESTROY and RTT_FOLD, which hold the rd granule lock until the
+	 * tree has been updated. It is odd while an RTT is being removed.
+	 */
+	unsigned long rtt_gen;
+
+	/* Number of lock-free RTT walks in progress */
+	unsigned long rtt_readers;
+
+	/* RTT walk cache */
+	struct rtt_walk_cache walk_cache;
+
+	/* RTT fold policy, RMI_REALM_FLAGS_FOLD_* */
+	unsigned long fold_flags;
+
+	/* RTT fold events which have not been read by RMI_RTT_FOLD_QUERY */
+	struct rtt_fold_event fold_events[RTT_FOLD_EVENTS];
+	unsigned int fold_head;
+	unsigned int fold_count;
+
+	/*
+	 * Number of SMMU streams owned by the realm. While it is not zero,
+	 * DATA granules are not released as they may be mapped by the SMMU.
+	 */
+	unsigned long smmu_streams;
+
+	/*
+	 * Descriptors of the devices assigned to the realm, in the DEV state.
+	 * Unused entries are NULL.
+	 */
+	struct granule *g_devs[REALM_MAX_DEVS];
+	unsigned int nr_devs;
+
 	/* Number of auxiliary REC granules for the Realm */
 	unsigned int num_rec_aux;
 
@@ -153,6 +230,37 @@ static inline int realm_rtt_starting_level(struct rd *rd)
 	return rd->s2_ctx.s2_starting_level;
 }
 
+/*
+ * Must be called with the rd granule lock held before an RTT is removed from
+ * the RTT tree. Lock-free walks started from now on fall back to a locked
+ * walk, and the ones in progress are waited for, so that none of them accesses
+ * the RTT once it has been released.
+ */
+static inline void rtt_remove_begin(struct rd *rd)
+{
+	SCA_WRITE64(&rd->rtt_gen, rd->rtt_gen + 1UL);
+	dmb(ish);
+
+	while (SCA_READ64_ACQUIRE(&rd->rtt_readers) != 0UL) {
+	}
+}
+
+/*
+ * Must be called with the rd granule lock held once an RTT has been removed
+ * from the RTT tree. This also invalidates the RTT walk cache of the realm.
+ */
+static inline void rtt_remove_end(struct rd *rd)
+{
+	SCA_WRITE64_RELEASE(&rd->rtt_gen, rd->rtt_gen + 1UL);
+}
+
+unsigned long *rtt_walk_lock_unlock_cached(struct rd *rd,
+					   unsigned long map_addr,
+					   long level,
+					   struct rtt_walk *wi);
+bool rtt_read_entry_lockless(struct rd *rd, unsigned long map_addr,
+			     unsigned long *s2tte, long *level);
+
 /*
  * Checks that 'address' is within container's parameters.
  *
@@ -231,6 +339,15 @@ struct s2_walk_result {
 	struct granule *llt;
 };
 
+/*
+ * Physically contiguous run of granules returned by realm_ipa_range_to_pa().
+ */
+struct s2_walk_run {
+	unsigned long ipa;
+	unsigned long pa;
+	unsigned long size;
+};
+
 static inline bool s2_walk_result_match_ripas(struct s2_walk_result *res,
 					      enum ripas ripas)
 {
@@ -241,6 +358,13 @@ enum s2_walk_status realm_ipa_to_pa(struct rd *rd,
 				    unsigned long ipa,
 				    struct s2_walk_result *res);
 
+enum s2_walk_status realm_ipa_range_to_pa(struct rd *rd,
+					  unsigned long ipa,
+					  unsigned long end,
+					  struct s2_walk_run *runs,
+					  unsigned int *nr_runs,
+					  struct s2_walk_result *s2_walk);
+
 enum s2_walk_status realm_ipa_get_ripas(struct rec *rec, unsigned long ipa,
 					enum ripas *ripas_ptr,
 					unsigned long *rtt_level);
@@ -131,6 +131,14 @@ struct rec {
 		enum ripas ripas;
 	} set_ripas;
 
+	/* Progress of a pending RSI_DEV_MEM request */
+	struct {
+		unsigned long start;
+		unsigned long end;
+		unsigned long addr;
+		unsigned long delegate;
+	} dev_mem;
+
 	/*
 	 * Common values across all RECs in a Realm.
 	 */
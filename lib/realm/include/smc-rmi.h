@@ -111,6 +111,10 @@
 #define RMI_NO_MEASURE_CONTENT 0
 #define RMI_MEASURE_CONTENT  1
 
+/* StreamID of the device attached by RMI_DATA_CREATE, in the flags */
+#define RMI_DATA_FLAGS_DEV_SID_SHIFT	32
+#define RMI_DATA_FLAGS_DEV_SID_WIDTH	32
+
 /*
  * arg0 == data address
  * arg1 == RD address
@@ -249,6 +253,201 @@
  */
 #define SMC_RMM_RTT_SET_RIPAS			SMC64_RMI_FID(U(0x19))
 
+/*
+ * arg0 == base address of the granule range
+ * arg1 == number of granules
+ * ret1 == address of the first granule which was not delegated
+ */
+#define SMC_RMM_GRANULE_DELEGATE_RANGE		SMC64_RMI_FID(U(0x1A))
+
+/*
+ * arg0 == base address of the granule range
+ * arg1 == number of granules
+ * ret1 == address of the first granule which was not undelegated
+ */
+#define SMC_RMM_GRANULE_UNDELEGATE_RANGE	SMC64_RMI_FID(U(0x1B))
+
+/*
+ * arg0 == address of the NS granule to which the statistics are written
+ * arg1 == index of the CPU
+ */
+#define SMC_RMM_GRANULE_LOCK_STATS		SMC64_RMI_FID(U(0x1C))
+
+/* Number of lock classes reported by RMI_GRANULE_LOCK_STATS */
+#define RMI_LOCK_STATS_CLASSES		U(8)
+
+/* Number of buckets in the lock hold time histograms */
+#define RMI_LOCK_STATS_HOLD_BUCKETS	U(16)
+
+/*
+ * Statistics of the granule locks of one lock class, collected on one CPU.
+ *
+ * hold_time[i] counts the locks held for [2^i, 2^(i + 1)) CNTVCT ticks.
+ * hold_time[0] also counts the locks held for less than one tick and the last
+ * bucket counts all the longer hold times.
+ */
+struct rmi_lock_class_stats {
+	/* Number of acquisitions */
+	unsigned long acquires;
+	/* Number of acquisitions which found the lock held */
+	unsigned long contended;
+	/* Number of iterations spent waiting for the lock */
+	unsigned long spins;
+	/* Hold time histogram */
+	unsigned long hold_time[RMI_LOCK_STATS_HOLD_BUCKETS];
+};
+
+/*
+ * Structure written to the Host by RMI_GRANULE_LOCK_STATS. The lock classes
+ * are indexed by granule state.
+ */
+struct rmi_lock_stats {
+	struct rmi_lock_class_stats classes[RMI_LOCK_STATS_CLASSES];
+};
+
+COMPILER_ASSERT(sizeof(struct rmi_lock_stats) == 0x4C0);
+
+/*
+ * arg0 == base address of the DATA granules
+ * arg1 == RD address
+ * arg2 == base map address
+ * arg3 == base address of the NS source granules
+ * arg4 == flags
+ * arg5 == number of granules
+ * ret1 == number of granules which were created
+ */
+#define SMC_RMM_DATA_CREATE_RANGE		SMC64_RMI_FID(U(0x1D))
+
+/*
+ * arg0 == RD address
+ * arg1 == base of the IPA range
+ * arg2 == top of the IPA range
+ * ret1 == address of the first entry which was not updated
+ */
+#define SMC_RMM_RTT_INIT_RIPAS_RANGE		SMC64_RMI_FID(U(0x1E))
+
+/*
+ * arg0 == RD address
+ * ret1 == RMI_RTT_FOLD_EVENT_*
+ * ret2 == base IPA of the range translated by the RTT
+ * ret3 == level of the RTT
+ * ret4 == RTT address
+ */
+#define SMC_RMM_RTT_FOLD_QUERY			SMC64_RMI_FID(U(0x1F))
+
+/*
+ * arg0 == RD address
+ * arg1 == base of the IPA range
+ * arg2 == top of the IPA range
+ * arg3 == address of the NS granule which receives the list of released
+ *	   granules, as struct rmi_released_granules entries
+ * ret1 == address from which the operation is to be resumed
+ * ret2 == number of entries written to the list
+ */
+#define SMC_RMM_RTT_TEARDOWN			SMC64_RMI_FID(U(0x20))
+
+/*
+ * Entry of the list written by RMI_RTT_TEARDOWN: @count contiguous granules
+ * from @addr have been released to the DELEGATED state.
+ */
+struct rmi_released_granules {
+	unsigned long addr;
+	unsigned long count;
+};
+
+/*
+ * arg0 == RD address
+ * arg1 == base of the IPA range
+ * arg2 == top of the IPA range
+ * arg3 == address of the NS granule which receives the records
+ * ret1 == level of the RTT entries which were read
+ * ret2 == number of records written
+ * ret3 == address of the first entry which was not read
+ */
+#define SMC_RMM_RTT_READ_ENTRIES		SMC64_RMI_FID(U(0x21))
+
+/*
+ * Record written by RMI_RTT_READ_ENTRIES for each RTT entry:
+ * - RmiRttEntryState,
+ * - RIPAS, for the Unassigned and Assigned states,
+ * - output address for the Assigned and Valid_NS states, or address of the
+ *   next level RTT for the Table state.
+ */
+#define RMI_RTT_RECORD_STATE_SHIFT	0
+#define RMI_RTT_RECORD_STATE_WIDTH	3
+#define RMI_RTT_RECORD_RIPAS_SHIFT	3
+#define RMI_RTT_RECORD_RIPAS_WIDTH	1
+#define RMI_RTT_RECORD_ADDR_SHIFT	12
+#define RMI_RTT_RECORD_ADDR_WIDTH	36
+
+/*
+ * arg0 == RD address
+ * arg1 == StreamID
+ * arg2 == address of the root SMMU stage 2 table
+ */
+#define SMC_RMM_SMMU_STREAM_CREATE		SMC64_RMI_FID(U(0x22))
+
+/*
+ * arg0 == RD address
+ * arg1 == StreamID
+ */
+#define SMC_RMM_SMMU_STREAM_DESTROY		SMC64_RMI_FID(U(0x23))
+
+/*
+ * arg0 == RD address
+ * arg1 == StreamID
+ * arg2 == address of the SMMU stage 2 table
+ */
+#define SMC_RMM_SMMU_TABLE_ADD			SMC64_RMI_FID(U(0x24))
+
+/*
+ * arg0 == RD address
+ * arg1 == StreamID
+ * arg2 == base of the IPA range
+ * arg3 == top of the IPA range
+ * ret1 == address from which the operation is to be resumed
+ */
+#define SMC_RMM_SMMU_MAP			SMC64_RMI_FID(U(0x25))
+
+/*
+ * arg0 == RD address
+ * arg1 == StreamID
+ * arg2 == base of the IOVA range
+ * arg3 == top of the IOVA range
+ * ret1 == address from which the operation is to be resumed
+ */
+#define SMC_RMM_SMMU_UNMAP			SMC64_RMI_FID(U(0x26))
+
+/*
+ * arg0 == RD address
+ * arg1 == address of the device descriptor granule
+ * arg2 == StreamID
+ */
+#define SMC_RMM_DEV_CREATE			SMC64_RMI_FID(U(0x27))
+
+/*
+ * arg0 == RD address
+ * arg1 == StreamID
+ */
+#define SMC_RMM_DEV_DESTROY			SMC64_RMI_FID(U(0x28))
+
+/* RmiRttFoldEvent type */
+#define RMI_RTT_FOLD_EVENT_NONE		U(0)
+/* The RTT can be folded by RMI_RTT_FOLD */
+#define RMI_RTT_FOLD_EVENT_CANDIDATE	U(1)
+/* The RTT has been folded and is now DELEGATED */
+#define RMI_RTT_FOLD_EVENT_FOLDED	U(2)
+
+/*
+ * RmiRealmFlags
+ * Report the RTTs which become foldable through RMI_RTT_FOLD_QUERY
+ */
+#define RMI_REALM_FLAGS_FOLD_REPORT	(UL(1) << 0)
+/* Fold the RTTs which become foldable and report them as folded */
+#define RMI_REALM_FLAGS_FOLD_AUTO	(UL(1) << 1)
+#define RMI_REALM_FLAGS_MASK		(RMI_REALM_FLAGS_FOLD_REPORT | \
+					 RMI_REALM_FLAGS_FOLD_AUTO)
+
 /* Size of Realm Personalization Value */
 #define RPV_SIZE		64
 
@@ -273,6 +472,8 @@ struct rmi_realm_params {
 			long rtt_level_start;			/* 0x810 */
 			/* Number of starting level RTTs */
 			unsigned int rtt_num_start;		/* 0x818 */
+			/* Flags, RMI_REALM_FLAGS_* */
+			unsigned long flags;			/* 0x820 */
 		   }, 0x800, 0x1000);
 };
 
@@ -285,6 +486,7 @@ COMPILER_ASSERT(offsetof(struct rmi_realm_params, vmid) == 0x800);
 COMPILER_ASSERT(offsetof(struct rmi_realm_params, rtt_base) == 0x808);
 COMPILER_ASSERT(offsetof(struct rmi_realm_params, rtt_level_start) == 0x810);
 COMPILER_ASSERT(offsetof(struct rmi_realm_params, rtt_num_start) == 0x818);
+COMPILER_ASSERT(offsetof(struct rmi_realm_params, flags) == 0x820);
 
 /*
  * The REC attribute parameters are shared by the Host via
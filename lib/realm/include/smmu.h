@@ -0,0 +1,79 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#ifndef SMMU_H
+#define SMMU_H
+
+#include <asc.h>
+#include <stdbool.h>
+#include <utils_def.h>
+
+/*
+ * Size of the IOVA space translated by the SMMU stage 2 tables. The tables
+ * use the stage 2 translation table format of the CPU, starting at level 0
+ * without concatenation.
+ */
+#define SMMU_S2_IOVA_BITS	48U
+#define SMMU_S2_START_LEVEL	0
+
+/* Maximum number of StreamIDs with RMM-managed stage 2 tables */
+#define SMMU_MAX_STREAMS	8U
+
+/* Maximum number of table granules of a stream, including the root */
+#define SMMU_STREAM_MAX_TABLES	64U
+
+/*
+ * SMMUv3 commands used to invalidate the stage 2 TLB entries of a stream.
+ * The VMID is in CMD[47:32] and, for CMD_TLBI_S2_IPA, the IPA[51:12] in
+ * CMD[115:76] and Leaf in CMD[64].
+ */
+#define SMMU_CMD_TLBI_S12_VMALL	0x28UL
+#define SMMU_CMD_TLBI_S2_IPA	0x2AUL
+#define SMMU_CMD_SYNC		0x46UL
+
+#define SMMU_CMD_VMID_SHIFT	32
+#define SMMU_CMD_LEAF		(1UL << 0)
+#define SMMU_CMD_ADDR_MASK	0x000FFFFFFFFFF000UL
+
+/*
+ * Number of commands recorded in an invalidation batch, including the
+ * terminating CMD_SYNC. Beyond it, all the entries of the VMID are
+ * invalidated with a single CMD_TLBI_S12_VMALL.
+ */
+#define SMMU_INV_BATCH_CMDS	32U
+COMPILER_ASSERT(SMMU_INV_BATCH_CMDS <= ASC_SMMU_CMD_MAX_ENTRIES);
+
+/*
+ * SMMU TLB invalidations accumulated while the stage 2 tables of a stream are
+ * updated, and passed to EL3 at once by smmu_inv_batch_flush().
+ */
+struct smmu_inv_batch {
+	unsigned int vmid;
+	unsigned int nr_cmds;
+	/* Invalidate all the entries of the VMID instead of @cmds */
+	bool vmall;
+	struct asc_smmu_cmd cmds[SMMU_INV_BATCH_CMDS];
+};
+
+struct granule;
+struct s2_walk_run;
+
+unsigned long smmu_stream_create(unsigned int sid, struct granule *g_rd,
+				 unsigned int vmid, struct granule *g_root);
+unsigned long smmu_stream_destroy(unsigned int sid, struct granule *g_rd);
+unsigned long smmu_stream_table_add(unsigned int sid, struct granule *g_rd,
+				    struct granule *g_tbl);
+struct granule *smmu_stream_rd(unsigned int sid);
+unsigned long smmu_stream_map(unsigned int sid, struct granule *g_rd,
+			      const struct s2_walk_run *runs,
+			      unsigned int nr_runs,
+			      unsigned long *mapped);
+unsigned long smmu_stream_unmap(unsigned int sid,
+				struct granule *g_rd,
+				unsigned long base,
+				unsigned long top,
+				unsigned long *next);
+
+#endif /* SMMU_H */
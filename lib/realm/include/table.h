@@ -67,6 +67,37 @@ bool addr_block_intersects_par(struct rd *rd, unsigned long addr, long level);
 unsigned long s2tte_map_size(int level);
 
 struct realm_s2_context;
+
+/* Maximum number of IPA ranges recorded by a stage 2 TLBI batch */
+#define S2TLBI_BATCH_RANGES	8U
+
+struct s2tlbi_range {
+	unsigned long ipa;
+	unsigned long size;
+};
+
+/*
+ * Stage 2 TLB invalidations accumulated while an RMI command updates several
+ * RTT entries of a realm, and issued at once by s2tlbi_batch_flush(), using
+ * range invalidations when FEAT_TLBIRANGE is implemented.
+ */
+struct s2tlbi_batch {
+	const struct realm_s2_context *s2_ctx;
+	unsigned int nr_ranges;
+	/* Total number of pages recorded in the batch */
+	unsigned long pages;
+	/* Invalidate all the entries of the VMID instead of @ranges */
+	bool vmid_flush;
+	struct s2tlbi_range ranges[S2TLBI_BATCH_RANGES];
+};
+
+void s2tlbi_batch_init(struct s2tlbi_batch *batch,
+		       const struct realm_s2_context *s2_ctx);
+void s2tlbi_batch_add(struct s2tlbi_batch *batch,
+		      unsigned long ipa,
+		      unsigned long size);
+void s2tlbi_batch_flush(struct s2tlbi_batch *batch);
+
 void invalidate_page(const struct realm_s2_context *ctx, unsigned long addr);
 void invalidate_block(const struct realm_s2_context *ctx, unsigned long addr);
 void invalidate_pages_in_block(const struct realm_s2_context *ctx, unsigned long addr);
@@ -90,6 +121,12 @@ void rtt_walk_lock_unlock(struct granule *g_root,
 			  unsigned long map_addr,
 			  long level,
 			  struct rtt_walk *wi);
+unsigned long *rtt_walk_lock_unlock_map(struct granule *g_root,
+					int start_level,
+					unsigned long ipa_bits,
+					unsigned long map_addr,
+					long level,
+					struct rtt_walk *wi);
 
 /*
  * The MMU is a separate observer, and requires that translation table updates
@@ -23,18 +23,26 @@
 #include <xlat_tables.h>
 
 /*
- * The VA space size for the high region, which maps the slot buffers,
- * needs to be a power of two, so round NR_CPU_SLOTS up to the closest
- * power of two.
+ * The VA space for the high region maps the slot buffers, followed by the
+ * slot window used to map several contiguous granules at once. The slot
+ * buffers and the window share a single last level translation table per CPU,
+ * so the VA space covers all of its entries.
  */
 #define ROUNDED_NR_CPU_SLOTS (1ULL << (64ULL - \
 				       __builtin_clzll((NR_CPU_SLOTS) - 1)))
 
-#define RMM_SLOT_BUF_VA_SIZE	((ROUNDED_NR_CPU_SLOTS) * (GRANULE_SIZE))
+#define RMM_SLOT_BUF_VA_SIZE	((XLAT_TABLE_ENTRIES) * (GRANULE_SIZE))
 
 #define SLOT_VIRT		((ULL(0xffffffffffffffff) - \
 				 RMM_SLOT_BUF_VA_SIZE + ULL(1)))
 
+/* The window takes the upper entries of the table */
+#define SLOT_WINDOW_VIRT	(SLOT_VIRT + RMM_SLOT_BUF_VA_SIZE - \
+				 (SLOT_WINDOW_MAX_GRANULES * GRANULE_SIZE))
+
+COMPILER_ASSERT((ROUNDED_NR_CPU_SLOTS + SLOT_WINDOW_MAX_GRANULES) <=
+		XLAT_TABLE_ENTRIES);
+
 /*
  * All the slot buffers for a given CPU must be mapped by a single translation
  * table, which means the max VA size should be <= 4KB * 512
@@ -93,6 +101,32 @@ static struct xlat_ctx slot_buf_xlat_ctx[MAX_CPUS];
  */
 static struct xlat_table_entry te_cache[MAX_CPUS];
 
+/*
+ * Per-CPU cache of the realm slot mappings.
+ *
+ * When a realm slot is unmapped, its mapping is left live in the slot table
+ * and only marked as not in use. If the same PA is mapped again in the slot,
+ * the mapping is reused without updating the translation tables. The mapping
+ * is only invalidated, including the TLB maintenance, when the slot is
+ * retargeted to a different PA. This avoids a TLBI per access on paths which
+ * map the same granules repeatedly, such as RTT walks.
+ *
+ * SLOT_NS is never cached, so that no mapping of NS memory is left live.
+ */
+struct slot_cache_entry {
+	/* VA of the live mapping, or NULL if the slot is not mapped */
+	void *va;
+	/* PA mapped in the slot */
+	unsigned long pa;
+	/* The slot is mapped by the caller of granule_map() */
+	bool in_use;
+};
+
+static struct slot_cache_entry slot_cache[MAX_CPUS][NR_CPU_SLOTS];
+
+/* Per-CPU number of granules mapped in the slot window, 0 if unused */
+static unsigned long slot_window_granules[MAX_CPUS];
+
 static uintptr_t slot_to_va(enum buffer_slot slot)
 {
 	assert(slot < NR_CPU_SLOTS);
@@ -110,6 +144,11 @@ static inline struct xlat_table_entry *get_cache_entry(void)
 	return &te_cache[my_cpuid()];
 }
 
+static inline struct slot_cache_entry *get_slot_cache(void)
+{
+	return &slot_cache[my_cpuid()][0];
+}
+
 __unused static uint64_t slot_to_descriptor(enum buffer_slot slot)
 {
 	uint64_t *entry = xlat_get_pte_from_table(get_cache_entry(),
@@ -222,10 +261,15 @@ void slot_buf_init(void)
  */
 void assert_cpu_slots_empty(void)
 {
+	__unused struct slot_cache_entry *cache = get_slot_cache();
 	unsigned int i;
 
+	assert(slot_to_descriptor(SLOT_NS) == INVALID_DESC);
+	assert(slot_window_granules[my_cpuid()] == 0UL);
+
+	/* The realm slots may still hold live mappings which are not in use */
 	for (i = 0; i < NR_CPU_SLOTS; i++) {
-		assert(slot_to_descriptor(i) == INVALID_DESC);
+		assert(!cache[i].in_use);
 	}
 }
 
@@ -263,17 +307,108 @@ static void ns_buffer_unmap(enum buffer_slot slot)
 void *granule_map(struct granule *g, enum buffer_slot slot)
 {
 	unsigned long addr = granule_addr(g);
+	struct slot_cache_entry *entry;
 
 	assert(is_realm_slot(slot));
 
+	entry = &get_slot_cache()[slot];
+	assert(!entry->in_use);
+
+	if (entry->va != NULL) {
+		if (entry->pa == addr) {
+			entry->in_use = true;
+			return entry->va;
+		}
+
+		/* Retarget the slot */
+		buffer_arch_unmap(entry->va);
+		entry->va = NULL;
+	}
+
 	// return buffer_arch_map(slot, addr, g->nsp); Pertie : we don't need this if we don't change gpt on context switches for the cores
-	return buffer_arch_map(slot, addr, false);
+	entry->va = buffer_arch_map(slot, addr, false);
+	if (entry->va != NULL) {
+		entry->pa = addr;
+		entry->in_use = true;
+	}
 
+	return entry->va;
 }
 
+/*
+ * Release a realm slot mapped with granule_map(). The mapping is kept live
+ * until the slot is retargeted.
+ */
 void buffer_unmap(void *buf)
 {
-	buffer_arch_unmap(buf);
+	struct slot_cache_entry *cache = get_slot_cache();
+	uintptr_t va = (uintptr_t)buf;
+	unsigned int i;
+
+	if ((va >= SLOT_VIRT) &&
+	    (va < (SLOT_VIRT + (NR_CPU_SLOTS * GRANULE_SIZE)))) {
+		i = (unsigned int)((va - SLOT_VIRT) / GRANULE_SIZE);
+		assert(cache[i].in_use && (cache[i].va == buf));
+		cache[i].in_use = false;
+		return;
+	}
+
+	/*
+	 * The buffer is not in the slot VA range when the slots are emulated
+	 * (e.g. on fake_host), so look it up in the cache.
+	 */
+	for (i = 0U; i < NR_CPU_SLOTS; i++) {
+		if (cache[i].in_use && (cache[i].va == buf)) {
+			cache[i].in_use = false;
+			return;
+		}
+	}
+
+	/* @buf is not a realm slot mapped by granule_map() */
+	assert(false);
+}
+
+/*
+ * Maps @num_granules physically contiguous granules starting at @addr in the
+ * slot window of the current CPU, returning the virtual address. The window
+ * is mapped with a single translation table update, using the contiguous hint
+ * where possible, and must be unmapped with buffer_unmap_window() before it
+ * can be mapped again.
+ *
+ * The caller must either hold the locks of all the granules, or hold a
+ * reference to them. @ns must be true if the granules are in NS state.
+ */
+void *buffer_map_window(unsigned long addr, unsigned long num_granules,
+			bool ns)
+{
+	unsigned long *mapped = &slot_window_granules[my_cpuid()];
+	void *va;
+
+	assert(GRANULE_ALIGNED(addr));
+	assert((num_granules != 0UL) &&
+	       (num_granules <= SLOT_WINDOW_MAX_GRANULES));
+	assert(*mapped == 0UL);
+
+	va = buffer_arch_map_window(addr, num_granules, ns);
+	if (va != NULL) {
+		*mapped = num_granules;
+	}
+
+	return va;
+}
+
+/*
+ * Unmaps the slot window of the current CPU with a single TLB
+ * synchronization.
+ */
+void buffer_unmap_window(void *buf)
+{
+	unsigned long *mapped = &slot_window_granules[my_cpuid()];
+
+	assert(*mapped != 0UL);
+
+	buffer_arch_unmap_window(buf, *mapped);
+	*mapped = 0UL;
 }
 
 bool memcpy_ns_read(void *dest, const void *ns_src, unsigned long size);
@@ -380,6 +515,39 @@ void *buffer_map_internal(enum buffer_slot slot, unsigned long addr, bool ns)
 	return (void *)va;
 }
 
+void *buffer_map_window_internal(unsigned long addr,
+				 unsigned long num_granules, bool ns)
+{
+	uint64_t attr = SLOT_DESC_ATTR;
+
+	assert(GRANULE_ALIGNED(addr));
+
+	attr |= (ns == true ? MT_NS : MT_REALM);
+
+	if (xlat_map_memory_range_with_attrs(get_cache_entry(),
+					     SLOT_WINDOW_VIRT,
+					     (uintptr_t)addr,
+					     num_granules * GRANULE_SIZE,
+					     attr) != 0) {
+		/* Error mapping the window */
+		return NULL;
+	}
+
+	return (void *)SLOT_WINDOW_VIRT;
+}
+
+void buffer_unmap_window_internal(void *buf, unsigned long num_granules)
+{
+	/*
+	 * Prevent the compiler from moving prior loads/stores to buf after the
+	 * update to the translation table. Otherwise, those could fault.
+	 */
+	COMPILER_BARRIER();
+
+	(void)xlat_unmap_memory_range(get_cache_entry(), (uintptr_t)buf,
+				      num_granules * GRANULE_SIZE);
+}
+
 void buffer_unmap_internal(void *buf)
 {
 	/*
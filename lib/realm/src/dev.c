@@ -0,0 +1,329 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <assert.h>
+#include <buffer.h>
+#include <dev.h>
+#include <granule.h>
+#include <realm.h>
+#include <smc-rmi.h>
+#include <spinlock.h>
+#include <string.h>
+
+enum dev_entry_state {
+	DEV_ENTRY_FREE = 0,
+	DEV_ENTRY_USED,
+	/* Removed entry, which does not end the probe sequences through it */
+	DEV_ENTRY_DELETED
+};
+
+/*
+ * Entry of the device registry. The owner of the device and its attach state
+ * are kept in the entry so that ownership checks do not need to map the
+ * descriptor granule.
+ */
+struct dev_entry {
+	enum dev_entry_state state;
+	unsigned int sid;
+	unsigned int vmid;
+	bool attached;
+	struct granule *g_rd;
+	struct granule *g_dev;
+};
+
+/*
+ * Protects dev_index[]. It is acquired after the RD and DEV granule locks, and
+ * no granule lock is acquired while it is held. The entry of a device is only
+ * removed with the RD of its realm locked, so the DEV granule of an entry
+ * found with the RD locked can be locked once dev_lock is released.
+ */
+static spinlock_t dev_lock;
+static struct dev_entry dev_index[DEV_INDEX_SIZE];
+static unsigned int dev_count;
+
+static unsigned int dev_hash(unsigned int sid)
+{
+	/* Fibonacci hashing, so that consecutive StreamIDs are spread */
+	return (sid * 0x9E3779B9U) >> (32U - DEV_INDEX_BITS);
+}
+
+static struct dev_entry *dev_index_entry(unsigned int sid, unsigned int i)
+{
+	return &dev_index[(dev_hash(sid) + i) & (DEV_INDEX_SIZE - 1U)];
+}
+
+static struct dev_entry *find_dev(unsigned int sid)
+{
+	for (unsigned int i = 0U; i < DEV_INDEX_SIZE; i++) {
+		struct dev_entry *e = dev_index_entry(sid, i);
+
+		if (e->state == DEV_ENTRY_FREE) {
+			break;
+		}
+
+		if ((e->state == DEV_ENTRY_USED) && (e->sid == sid)) {
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
+/* Must be called with dev_lock held and @sid not in the registry */
+static struct dev_entry *alloc_dev(unsigned int sid)
+{
+	for (unsigned int i = 0U; i < DEV_INDEX_SIZE; i++) {
+		struct dev_entry *e = dev_index_entry(sid, i);
+
+		if (e->state != DEV_ENTRY_USED) {
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
+static void free_dev(struct dev_entry *e)
+{
+	struct dev_entry *next = &dev_index[((unsigned int)(e - dev_index) + 1U) &
+					    (DEV_INDEX_SIZE - 1U)];
+
+	/* No probe sequence goes through @e if the next entry is free */
+	e->state = (next->state == DEV_ENTRY_FREE) ?
+		   DEV_ENTRY_FREE : DEV_ENTRY_DELETED;
+	e->g_rd = NULL;
+	e->g_dev = NULL;
+	dev_count--;
+}
+
+/*
+ * Registers the device with StreamID @sid as assigned to the realm whose RD
+ * is @g_rd, mapped at @rd, and stores its descriptor in @g_dev. @g_rd must be
+ * locked and @g_dev locked in the DELEGATED state. The caller takes the
+ * reference held by the device on the RD on success.
+ */
+unsigned long dev_create(unsigned int sid, struct granule *g_rd,
+			 struct rd *rd, struct granule *g_dev)
+{
+	struct dev_entry *e;
+	struct dev_desc *desc;
+	unsigned int i;
+	unsigned long ret;
+
+	if (rd->nr_devs == REALM_MAX_DEVS) {
+		return RMI_ERROR_REALM;
+	}
+
+	spinlock_acquire(&dev_lock);
+
+	if (find_dev(sid) != NULL) {
+		ret = RMI_ERROR_IN_USE;
+		goto out;
+	}
+
+	e = (dev_count < DEV_MAX_DEVS) ? alloc_dev(sid) : NULL;
+	if (e == NULL) {
+		ret = RMI_ERROR_IN_USE;
+		goto out;
+	}
+
+	granule_scrub_on_use(g_dev, SLOT_DELEGATED);
+
+	desc = granule_map(g_dev, SLOT_DEV);
+	desc->sid = sid;
+	desc->vmid = rd->s2_ctx.vmid;
+	desc->attached = false;
+	desc->nr_bars = 0U;
+	buffer_unmap(desc);
+
+	granule_set_state(g_dev, GRANULE_STATE_DEV);
+
+	e->sid = sid;
+	e->vmid = rd->s2_ctx.vmid;
+	e->attached = false;
+	e->g_rd = g_rd;
+	e->g_dev = g_dev;
+	e->state = DEV_ENTRY_USED;
+	dev_count++;
+
+	for (i = 0U; rd->g_devs[i] != NULL; i++) {
+		assert(i < (REALM_MAX_DEVS - 1U));
+	}
+	rd->g_devs[i] = g_dev;
+	rd->nr_devs++;
+	ret = RMI_SUCCESS;
+
+out:
+	spinlock_release(&dev_lock);
+	return ret;
+}
+
+/*
+ * Removes the device with StreamID @sid, assigned to the realm whose RD is
+ * @g_rd, from the registry and releases its descriptor to the DELEGATED
+ * state. @g_rd must be locked, the caller drops the reference held by the
+ * device on success.
+ */
+unsigned long dev_destroy(unsigned int sid, struct granule *g_rd,
+			  struct rd *rd)
+{
+	struct dev_entry *e;
+	struct granule *g_dev;
+
+	spinlock_acquire(&dev_lock);
+
+	e = find_dev(sid);
+	if ((e == NULL) || (e->g_rd != g_rd)) {
+		spinlock_release(&dev_lock);
+		return RMI_ERROR_INPUT;
+	}
+
+	g_dev = e->g_dev;
+	free_dev(e);
+
+	spinlock_release(&dev_lock);
+
+	granule_lock(g_dev, GRANULE_STATE_DEV);
+	granule_memzero(g_dev, SLOT_DEV);
+	granule_unlock_transition(g_dev, GRANULE_STATE_DELEGATED);
+
+	for (unsigned int i = 0U; i < REALM_MAX_DEVS; i++) {
+		if (rd->g_devs[i] == g_dev) {
+			rd->g_devs[i] = NULL;
+			rd->nr_devs--;
+			break;
+		}
+	}
+
+	return RMI_SUCCESS;
+}
+
+/*
+ * Records the @nr_bars BARs of @bars in the descriptor of the device with
+ * StreamID @sid and marks it attached. The device must be assigned to the
+ * realm whose RD is @g_rd, which must be locked.
+ */
+unsigned long dev_attach(unsigned int sid, struct granule *g_rd,
+			 const struct dev_bar *bars, unsigned int nr_bars)
+{
+	struct dev_entry *e;
+	struct dev_desc *desc;
+	struct granule *g_dev;
+
+	if (nr_bars > DEV_MAX_BARS) {
+		return RMI_ERROR_INPUT;
+	}
+
+	spinlock_acquire(&dev_lock);
+
+	e = find_dev(sid);
+	if ((e == NULL) || (e->g_rd != g_rd)) {
+		spinlock_release(&dev_lock);
+		return RMI_ERROR_INPUT;
+	}
+
+	if (e->attached) {
+		spinlock_release(&dev_lock);
+		return RMI_ERROR_IN_USE;
+	}
+
+	g_dev = e->g_dev;
+
+	spinlock_release(&dev_lock);
+
+	/* The entry cannot be removed or attached while @g_rd is locked */
+	granule_lock(g_dev, GRANULE_STATE_DEV);
+	desc = granule_map(g_dev, SLOT_DEV);
+	(void)memcpy(desc->bars, bars, nr_bars * sizeof(struct dev_bar));
+	desc->nr_bars = nr_bars;
+	desc->attached = true;
+	buffer_unmap(desc);
+	granule_unlock(g_dev);
+
+	spinlock_acquire(&dev_lock);
+	e->attached = true;
+	spinlock_release(&dev_lock);
+
+	return RMI_SUCCESS;
+}
+
+/*
+ * Returns true if the device with StreamID @sid is assigned to the realm
+ * whose RD is @g_rd. If not NULL, @vmid and @attached are set to the VMID of
+ * the realm and to the attach state of the device.
+ */
+bool dev_lookup(unsigned int sid, struct granule *g_rd,
+		unsigned int *vmid, bool *attached)
+{
+	struct dev_entry *e;
+	bool owned = false;
+
+	spinlock_acquire(&dev_lock);
+
+	e = find_dev(sid);
+	if ((e != NULL) && (e->g_rd == g_rd)) {
+		if (vmid != NULL) {
+			*vmid = e->vmid;
+		}
+		if (attached != NULL) {
+			*attached = e->attached;
+		}
+		owned = true;
+	}
+
+	spinlock_release(&dev_lock);
+	return owned;
+}
+
+/*
+ * Returns true if each granule of the PA range [@pa, @pa + @size) is within a
+ * BAR of a device attached to the realm mapped at @rd. The range may span
+ * adjacent BARs. The RD granule must be locked.
+ */
+bool dev_pa_range_owned(struct rd *rd, unsigned long pa, unsigned long size)
+{
+	unsigned long end = pa + size;
+	bool progress = true;
+
+	if (end < pa) {
+		return false;
+	}
+
+	/*
+	 * Each pass moves @pa to the end of the BARs which contain it, until
+	 * the end of the range is reached or no BAR contains @pa.
+	 */
+	while ((pa < end) && progress) {
+		progress = false;
+
+		for (unsigned int i = 0U; i < REALM_MAX_DEVS; i++) {
+			struct granule *g_dev = rd->g_devs[i];
+			struct dev_desc *desc;
+
+			if (g_dev == NULL) {
+				continue;
+			}
+
+			granule_lock(g_dev, GRANULE_STATE_DEV);
+			desc = granule_map(g_dev, SLOT_DEV);
+
+			for (unsigned int b = 0U; desc->attached &&
+			     (b < desc->nr_bars); b++) {
+				const struct dev_bar *bar = &desc->bars[b];
+
+				if ((pa >= bar->pa) &&
+				    ((pa - bar->pa) < bar->size)) {
+					pa = bar->pa + bar->size;
+					progress = true;
+				}
+			}
+
+			buffer_unmap(desc);
+			granule_unlock(g_dev);
+		}
+	}
+
+	return (pa >= end);
+}
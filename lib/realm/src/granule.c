@@ -15,8 +15,36 @@
 #include <string.h>
 #include <utils_def.h>
 
+/*
+ * The size of struct granule is used by the build system to report the
+ * footprint of the granule metadata (see RMM_GRANULE_DESC_SIZE).
+ */
+COMPILER_ASSERT(sizeof(struct granule) == RMM_GRANULE_DESC_SIZE);
+
 static struct granule granules[RMM_MAX_GRANULES];
 
+#ifdef RMM_GRANULE_TICKET_LOCK
+/* The ticket lock has 8-bit tickets */
+COMPILER_ASSERT(MAX_CPUS <= 255U);
+#endif
+
+/* Number of contended acquisitions of a granule lock, per lock class */
+static uint64_t granule_lock_contention[GRANULE_LOCK_CLASSES];
+
+void granule_lock_contended(enum granule_state lock_class)
+{
+	assert((unsigned int)lock_class < GRANULE_LOCK_CLASSES);
+
+	atomic_add_64(&granule_lock_contention[lock_class], 1L);
+}
+
+unsigned long granule_lock_contention_count(enum granule_state lock_class)
+{
+	assert((unsigned int)lock_class < GRANULE_LOCK_CLASSES);
+
+	return __sca_read64(&granule_lock_contention[lock_class]);
+}
+
 /*
  * Takes a valid pointer to a struct granule, and returns the granule physical
  * address.
@@ -124,14 +152,6 @@ struct granule *find_lock_granule(unsigned long addr,
 	return g;
 }
 
-struct granule_set {
-	unsigned int idx;
-	unsigned long addr;
-	enum granule_state state;
-	struct granule *g;
-	struct granule **g_ret;
-};
-
 /*
  * Sort a set of granules by their address.
  */
@@ -159,11 +179,15 @@ static void sort_granules(struct granule_set *granules,
  *
  * @granules: Pointer to array of @n items.  Each item must be pre-populated
  *		with ->addr set to the granule's address, and ->state set to
- *		the expected state of the granule, and ->g_ret pointing to
- *		a valid 'struct granule *'.
- *		This function sorts the supplied array in place.
+ *		the expected state of the granule, and ->g_ret either NULL or
+ *		pointing to a valid 'struct granule *'.
+ *		This function sorts the supplied array in place, ->idx is set
+ *		to the position of the item before sorting.
  * @n: Number of struct granule_set in array pointed to by @granules
  *
+ * The granules are locked in a single pass and no memory other than @granules
+ * is used, so the stack usage does not depend on @n.
+ *
  * Returns:
  *     True if all granules in @granules were successfully locked.
  *
@@ -177,13 +201,13 @@ static void sort_granules(struct granule_set *granules,
  * locking rules in granule_types.h.
  *
  * If the function succeeds, for all items in @granules, ->g points to a locked
- * granule in ->state and *->g_ret is set to the pointer value.
+ * granule in ->state and *->g_ret, if not NULL, is set to the pointer value.
+ * The granules can be unlocked together with granule_unlock_set().
  *
  * If the function fails, no lock is held and no *->g_ret pointers are
  * modified.
  */
-static bool find_lock_granules(struct granule_set *granules,
-				unsigned long n)
+bool find_lock_granules(struct granule_set *granules, unsigned long n)
 {
 	long i;
 
@@ -207,7 +231,9 @@ static bool find_lock_granules(struct granule_set *granules,
 	}
 
 	for (i = 0L; i < n; i++) {
-		*granules[i].g_ret = granules[i].g;
+		if (granules[i].g_ret != NULL) {
+			*granules[i].g_ret = granules[i].g;
+		}
 	}
 
 	return true;
@@ -220,6 +246,17 @@ out_err:
 	return false;
 }
 
+/*
+ * Unlock a set of granules locked by find_lock_granules(). The granules are
+ * unlocked in the reverse order of locking.
+ */
+void granule_unlock_set(struct granule_set *granules, unsigned long n)
+{
+	for (unsigned long i = n; i > 0UL; i--) {
+		granule_unlock(granules[i - 1UL].g);
+	}
+}
+
 /*
  * Find two granules and lock them in order of their address.
  *
@@ -258,3 +295,29 @@ void granule_memzero_mapped(void *buf)
 {
 	(void)memset(buf, 0, GRANULE_SIZE);
 }
+
+/*
+ * Zero the content of a DELEGATED granule which is about to be used, if it has
+ * not been zeroed since it was delegated. The granule is mapped in @slot.
+ *
+ * Must be called with g->lock held.
+ */
+void granule_scrub_on_use(struct granule *g, enum buffer_slot slot)
+{
+	if (granule_needs_scrub(g)) {
+		granule_memzero(g, slot);
+		granule_clear_needs_scrub(g);
+	}
+}
+
+/*
+ * Same as granule_scrub_on_use() for a granule which is already mapped at
+ * @buf.
+ */
+void granule_scrub_mapped_on_use(struct granule *g, void *buf)
+{
+	if (granule_needs_scrub(g)) {
+		granule_memzero_mapped(buf);
+		granule_clear_needs_scrub(g);
+	}
+}
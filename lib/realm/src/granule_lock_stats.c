@@ -0,0 +1,155 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <arch_helpers.h>
+#include <assert.h>
+#include <cpuid.h>
+#include <debug.h>
+#include <granule.h>
+#include <smc-rmi.h>
+#include <string.h>
+#include <utils_def.h>
+
+/*
+ * Maximum number of granule locks held at the same time by a CPU for which the
+ * hold time is recorded. Deeper nested locks are only counted.
+ */
+#define GRANULE_LOCK_MAX_HELD	8U
+
+struct held_granule_lock {
+	struct granule *g;
+	unsigned int lock_class;
+	unsigned long start;
+};
+
+/*
+ * Per-CPU lock statistics. Each CPU only updates its own entry, so no
+ * synchronization is needed. Readers on other CPUs may observe counters which
+ * are slightly inconsistent with each other.
+ */
+struct granule_lock_cpu_stats {
+	struct rmi_lock_stats stats;
+	/* Number of locks held, including the ones not recorded in @held */
+	unsigned int num_held;
+	/* Number of valid entries in @held, in acquisition order */
+	unsigned int num_tracked;
+	struct held_granule_lock held[GRANULE_LOCK_MAX_HELD];
+};
+
+COMPILER_ASSERT(GRANULE_LOCK_CLASSES <= RMI_LOCK_STATS_CLASSES);
+
+static struct granule_lock_cpu_stats cpu_stats[MAX_CPUS];
+
+static unsigned int hold_time_bucket(unsigned long ticks)
+{
+	unsigned int bucket;
+
+	if (ticks < 2UL) {
+		return 0U;
+	}
+
+	bucket = 63U - (unsigned int)__builtin_clzl(ticks);
+
+	return (bucket < RMI_LOCK_STATS_HOLD_BUCKETS) ?
+		bucket : (RMI_LOCK_STATS_HOLD_BUCKETS - 1U);
+}
+
+void granule_lock_stats_acquired(struct granule *g,
+				 enum granule_state lock_class,
+				 unsigned int spins)
+{
+	struct granule_lock_cpu_stats *cs = &cpu_stats[my_cpuid()];
+	struct rmi_lock_class_stats *cls;
+
+	assert((unsigned int)lock_class < GRANULE_LOCK_CLASSES);
+
+	cls = &cs->stats.classes[lock_class];
+	cls->acquires++;
+	if (spins != 0U) {
+		cls->contended++;
+		cls->spins += spins;
+	}
+
+	if (cs->num_tracked < GRANULE_LOCK_MAX_HELD) {
+		struct held_granule_lock *h = &cs->held[cs->num_tracked++];
+
+		h->g = g;
+		h->lock_class = (unsigned int)lock_class;
+		h->start = read_cntvct_el0();
+	}
+
+	cs->num_held++;
+}
+
+void granule_lock_stats_released(struct granule *g)
+{
+	struct granule_lock_cpu_stats *cs = &cpu_stats[my_cpuid()];
+	unsigned int top = cs->num_tracked;
+	unsigned int i;
+
+	assert(cs->num_held != 0U);
+	cs->num_held--;
+
+	/*
+	 * Locks are not necessarily released in the reverse order. A lock
+	 * which is not found was acquired while @held was full and only
+	 * counted.
+	 */
+	for (i = top; i > 0U; i--) {
+		struct held_granule_lock *h = &cs->held[i - 1U];
+		unsigned long ticks;
+
+		if (h->g != g) {
+			continue;
+		}
+
+		ticks = read_cntvct_el0() - h->start;
+		cs->stats.classes[h->lock_class].hold_time[
+					hold_time_bucket(ticks)]++;
+
+		/* Remove the entry, keeping the others in acquisition order */
+		(void)memmove(h, h + 1,
+			      (top - i) * sizeof(struct held_granule_lock));
+		cs->held[top - 1U].g = NULL;
+		cs->num_tracked--;
+		break;
+	}
+}
+
+bool granule_lock_stats_read(unsigned int cpu_id,
+			     struct rmi_lock_stats *stats)
+{
+	if (cpu_id >= MAX_CPUS) {
+		return false;
+	}
+
+	(void)memcpy(stats, &cpu_stats[cpu_id].stats, sizeof(*stats));
+	return true;
+}
+
+void granule_lock_stats_dump(void)
+{
+	for (unsigned int cpu = 0U; cpu < MAX_CPUS; cpu++) {
+		for (unsigned int c = 0U; c < GRANULE_LOCK_CLASSES; c++) {
+			struct rmi_lock_class_stats *cls =
+				&cpu_stats[cpu].stats.classes[c];
+
+			if (cls->acquires == 0UL) {
+				continue;
+			}
+
+			INFO("CPU %u lock class %u: acquires %lu contended %lu spins %lu\n",
+			     cpu, c, cls->acquires, cls->contended, cls->spins);
+
+			for (unsigned int b = 0U;
+			     b < RMI_LOCK_STATS_HOLD_BUCKETS; b++) {
+				if (cls->hold_time[b] != 0UL) {
+					INFO("  hold time bucket %u: %lu\n",
+					     b, cls->hold_time[b]);
+				}
+			}
+		}
+	}
+}
@@ -8,5 +8,7 @@
 
 #define buffer_arch_map			buffer_map_internal
 #define buffer_arch_unmap		buffer_unmap_internal
+#define buffer_arch_map_window		buffer_map_window_internal
+#define buffer_arch_unmap_window	buffer_unmap_window_internal
 
 #endif /* SLOT_BUF_ARCH_H */
@@ -19,4 +19,15 @@ static void buffer_arch_unmap(void *buf)
 	return host_buffer_arch_unmap(buf);
 }
 
+static void *buffer_arch_map_window(unsigned long addr,
+				    unsigned long num_granules, bool ns)
+{
+	return host_buffer_arch_map_window(addr, num_granules, ns);
+}
+
+static void buffer_arch_unmap_window(void *buf, unsigned long num_granules)
+{
+	return host_buffer_arch_unmap_window(buf, num_granules);
+}
+
 #endif /* SLOT_BUF_ARCH_H */
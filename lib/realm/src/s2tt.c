@@ -3,7 +3,9 @@
  * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
  */
 
+#include <arch_features.h>
 #include <arch_helpers.h>
+#include <atomics.h>
 #include <attestation_token.h>
 #include <bitmap.h>
 #include <buffer.h>
@@ -130,11 +132,115 @@
 #define NR_RTT_LEVELS	4
 
 /*
- * Invalidates S2 TLB entries from [ipa, ipa + size] region tagged with `vmid`.
+ * Each RTT level has its own buffer slot so that a walk maps every table in
+ * the slot of its level. As slot mappings are kept live, the tables shared by
+ * consecutive walks (typically the root and the upper levels) are not remapped.
  */
-static void stage2_tlbi_ipa(const struct realm_s2_context *s2_ctx,
-			    unsigned long ipa,
-			    unsigned long size)
+#define RTT_WALK_SLOT(level)	\
+	((enum buffer_slot)((unsigned int)SLOT_RTT_L0 + (unsigned int)(level)))
+
+COMPILER_ASSERT((SLOT_RTT_L3 - SLOT_RTT_L0 + 1) == NR_RTT_LEVELS);
+
+/*
+ * Above these numbers of pages, a stage 2 TLBI batch is flushed by
+ * invalidating all the entries of the VMID rather than by issuing one TLBI per
+ * page, or one TLBI per range when FEAT_TLBIRANGE is implemented.
+ */
+#define S2TLBI_VMID_FLUSH_PAGES		(64UL)
+#define S2TLBI_RANGE_VMID_FLUSH_PAGES	(S2TTES_PER_S2TT * S2TTES_PER_S2TT)
+
+COMPILER_ASSERT(S2TLBI_RANGE_VMID_FLUSH_PAGES <
+	(TLBI_RANGE_NUM_MAX << ((5UL * TLBI_RANGE_SCALE_MAX) + 1UL)));
+
+/*
+ * Invalidates the S2 TLB entries of the `current vmid` for @pages pages from
+ * @ipa, using TLBI RIPAS2E1IS.
+ *
+ * A range operation covers (NUM + 1) * 2^(5 * SCALE + 1) pages, which is
+ * always an even number, so an odd page is invalidated on its own. The
+ * remaining pages are then covered from the lowest SCALE upwards, as in the
+ * Arm ARM description of the range operand.
+ */
+static void stage2_tlbi_ipa_range(unsigned long ipa, unsigned long pages)
+{
+	unsigned long scale = 0UL;
+
+	if ((pages & 1UL) != 0UL) {
+		tlbiipas2e1is(ipa >> GRANULE_SHIFT);
+		ipa += GRANULE_SIZE;
+		pages--;
+	}
+
+	while (pages != 0UL) {
+		unsigned long shift = (5UL * scale) + 1UL;
+		unsigned long num = (pages >> shift) & (TLBI_RANGE_NUM_MAX - 1UL);
+
+		assert(scale <= TLBI_RANGE_SCALE_MAX);
+
+		if (num != 0UL) {
+			tlbiripas2e1is(TLBI_RANGE_TG_4K |
+				       (scale << TLBI_RANGE_SCALE_SHIFT) |
+				       ((num - 1UL) << TLBI_RANGE_NUM_SHIFT) |
+				       ((ipa >> GRANULE_SHIFT) &
+					TLBI_RANGE_BADDR_MASK));
+			ipa += (num << shift) * GRANULE_SIZE;
+			pages -= num << shift;
+		}
+		scale++;
+	}
+}
+
+void s2tlbi_batch_init(struct s2tlbi_batch *batch,
+		       const struct realm_s2_context *s2_ctx)
+{
+	batch->s2_ctx = s2_ctx;
+	batch->nr_ranges = 0U;
+	batch->pages = 0UL;
+	batch->vmid_flush = false;
+}
+
+/*
+ * Records the invalidation of the S2 TLB entries of [ipa, ipa + size) in
+ * @batch. A range adjacent to the last recorded one is merged with it. If the
+ * batch is full, it falls back to invalidating all the entries of the VMID.
+ */
+void s2tlbi_batch_add(struct s2tlbi_batch *batch,
+		      unsigned long ipa,
+		      unsigned long size)
+{
+	struct s2tlbi_range *last;
+
+	assert(GRANULE_ALIGNED(ipa) && GRANULE_ALIGNED(size) && (size != 0UL));
+
+	batch->pages += size >> GRANULE_SHIFT;
+
+	if (batch->vmid_flush) {
+		return;
+	}
+
+	if (batch->nr_ranges != 0U) {
+		last = &batch->ranges[batch->nr_ranges - 1U];
+		if ((last->ipa + last->size) == ipa) {
+			last->size += size;
+			return;
+		}
+	}
+
+	if (batch->nr_ranges == S2TLBI_BATCH_RANGES) {
+		batch->vmid_flush = true;
+		return;
+	}
+
+	last = &batch->ranges[batch->nr_ranges++];
+	last->ipa = ipa;
+	last->size = size;
+}
+
+/*
+ * Issues the S2 TLB invalidations recorded in @batch and empties it. This must
+ * be done before the RTTs whose entries were invalidated are unlocked.
+ */
+void s2tlbi_batch_flush(struct s2tlbi_batch *batch)
 {
 	/*
 	 * Notes:
@@ -145,40 +251,69 @@ static void stage2_tlbi_ipa(const struct realm_s2_context *s2_ctx,
 	 * - @TODO: Provide additional information to this primitive so that
 	 *   we can utilize:
 	 *   - The TTL level hint, see FEAT_TTL,
-	 *   - Final level lookup only invalidation,
-	 *   - Address range invalidation.
+	 *   - Final level lookup only invalidation.
 	 */
+	unsigned long old_vttbr_el2;
+	bool range = is_feat_tlbirange_present();
+	unsigned int i;
+
+	if ((batch->nr_ranges == 0U) && !batch->vmid_flush) {
+		return;
+	}
 
 	/*
 	 * Save the current content of vttb_el2.
 	 */
-	unsigned long old_vttbr_el2 = read_vttbr_el2();
+	old_vttbr_el2 = read_vttbr_el2();
 
 	/*
 	 * Make 'vmid' the `current vmid`. Note that the tlbi instructions
 	 * bellow target the TLB entries that match the `current vmid`.
 	 */
-	write_vttbr_el2(INPLACE(VTTBR_EL2_VMID, s2_ctx->vmid));
+	write_vttbr_el2(INPLACE(VTTBR_EL2_VMID, batch->s2_ctx->vmid));
 	isb();
 
-	/*
-	 * Invalidate entries in S2 TLB caches that
-	 * match both `ipa` & the `current vmid`.
-	 */
-	while (size != 0UL) {
-		tlbiipas2e1is(ipa >> 12);
-		size -= GRANULE_SIZE;
-		ipa += GRANULE_SIZE;
-	}
-	dsb(ish);
+	if (batch->vmid_flush ||
+	    (batch->pages > (range ? S2TLBI_RANGE_VMID_FLUSH_PAGES :
+				     S2TLBI_VMID_FLUSH_PAGES))) {
+		/*
+		 * Invalidate all the Stage-1 and Stage-2 entries of the
+		 * `current vmid`.
+		 */
+		tlbivmalls12e1is();
+		dsb(ish);
+	} else {
+		/*
+		 * Invalidate entries in S2 TLB caches that
+		 * match both `ipa` & the `current vmid`.
+		 */
+		for (i = 0U; i < batch->nr_ranges; i++) {
+			unsigned long ipa = batch->ranges[i].ipa;
+			unsigned long pages =
+				batch->ranges[i].size >> GRANULE_SHIFT;
+
+			if (range && (pages > 1UL)) {
+				stage2_tlbi_ipa_range(ipa, pages);
+				continue;
+			}
+
+			while (pages != 0UL) {
+				tlbiipas2e1is(ipa >> GRANULE_SHIFT);
+				ipa += GRANULE_SIZE;
+				pages--;
+			}
+		}
+		dsb(ish);
 
-	/*
-	 * The architecture does not require TLB invalidation by IPA to affect
-	 * combined Stage-1 + Stage-2 TLBs. Therefore we must invalidate all of
-	 * Stage-1 (tagged with the `current vmid`) after invalidating Stage-2.
-	 */
-	tlbivmalle1is();
-	dsb(ish);
+		/*
+		 * The architecture does not require TLB invalidation by IPA to
+		 * affect combined Stage-1 + Stage-2 TLBs. Therefore we must
+		 * invalidate all of Stage-1 (tagged with the `current vmid`)
+		 * after invalidating Stage-2.
+		 */
+		tlbivmalle1is();
+		dsb(ish);
+	}
 	isb();
 
 	/*
@@ -186,6 +321,22 @@ static void stage2_tlbi_ipa(const struct realm_s2_context *s2_ctx,
 	 */
 	write_vttbr_el2(old_vttbr_el2);
 	isb();
+
+	s2tlbi_batch_init(batch, batch->s2_ctx);
+}
+
+/*
+ * Invalidates S2 TLB entries from [ipa, ipa + size] region tagged with `vmid`.
+ */
+static void stage2_tlbi_ipa(const struct realm_s2_context *s2_ctx,
+			    unsigned long ipa,
+			    unsigned long size)
+{
+	struct s2tlbi_batch batch;
+
+	s2tlbi_batch_init(&batch, s2_ctx);
+	s2tlbi_batch_add(&batch, ipa, size);
+	s2tlbi_batch_flush(&batch);
 }
 
 /*
@@ -281,11 +432,12 @@ static inline bool entry_is_table(unsigned long entry)
 }
 
 static unsigned long __table_get_entry(struct granule *g_tbl,
-				       unsigned long idx)
+				       unsigned long idx,
+				       long level)
 {
 	unsigned long *table, entry;
 
-	table = granule_map(g_tbl, SLOT_RTT);
+	table = granule_map(g_tbl, RTT_WALK_SLOT(level));
 	entry = s2tte_read(&table[idx]);
 	buffer_unmap(table);
 
@@ -293,9 +445,10 @@ static unsigned long __table_get_entry(struct granule *g_tbl,
 }
 
 static struct granule *__find_next_level_idx(struct granule *g_tbl,
-					     unsigned long idx)
+					     unsigned long idx,
+					     long level)
 {
-	const unsigned long entry = __table_get_entry(g_tbl, idx);
+	const unsigned long entry = __table_get_entry(g_tbl, idx, level);
 
 	if (!entry_is_table(entry)) {
 		return NULL;
@@ -309,7 +462,7 @@ static struct granule *__find_lock_next_level(struct granule *g_tbl,
 					      long level)
 {
 	const unsigned long idx = s2_addr_to_idx(map_addr, level);
-	struct granule *g = __find_next_level_idx(g_tbl, idx);
+	struct granule *g = __find_next_level_idx(g_tbl, idx, level);
 
 	if (g != NULL) {
 		granule_lock(g, GRANULE_STATE_RTT);
@@ -390,6 +543,162 @@ out:
 	wi->index = s2_addr_to_idx(map_addr, last_level);
 }
 
+/*
+ * Same as rtt_walk_lock_unlock(), but also maps the last level table reached
+ * by the walk and returns a pointer to it. The table is mapped in the walk
+ * slot of its level, which normally still holds the mapping established by a
+ * previous walk, so no additional mapping is needed in the common case.
+ *
+ * The caller must unmap the returned table with buffer_unmap() before
+ * unlocking rtt_walk.g_llt.
+ */
+unsigned long *rtt_walk_lock_unlock_map(struct granule *g_root,
+					int start_level,
+					unsigned long ipa_bits,
+					unsigned long map_addr,
+					long level,
+					struct rtt_walk *wi)
+{
+	rtt_walk_lock_unlock(g_root, start_level, ipa_bits, map_addr,
+			     level, wi);
+
+	return granule_map(wi->g_llt, RTT_WALK_SLOT(wi->last_level));
+}
+
+/*
+ * Walk the RTT tree of the realm described by @rd until level @level using
+ * @map_addr, in the same way as rtt_walk_lock_unlock_map(). The root RTT does
+ * not need to be locked before the call.
+ *
+ * The last level table reached is recorded in the walk cache of the realm.
+ * A later walk to the same level and within the IPA range translated by that
+ * table locks the cached table directly instead of walking down from the
+ * root, as long as no RTT has been removed from the tree in between, which is
+ * tracked by rd::rtt_gen.
+ *
+ * The caller must hold the rd granule lock during the call. RTT_DESTROY and
+ * RTT_FOLD keep the rd locked until the tree is updated, so the cache can
+ * neither be filled nor used while an RTT is being removed.
+ */
+unsigned long *rtt_walk_lock_unlock_cached(struct rd *rd,
+					   unsigned long map_addr,
+					   long level,
+					   struct rtt_walk *wi)
+{
+	struct rtt_walk_cache *wc = &rd->walk_cache;
+	int sl = realm_rtt_starting_level(rd);
+	unsigned long *s2tt;
+	unsigned long ipa;
+
+	/* The starting level tables are always reached without a walk */
+	if (level <= sl) {
+		granule_lock(rd->s2_ctx.g_rtt, GRANULE_STATE_RTT);
+		return rtt_walk_lock_unlock_map(rd->s2_ctx.g_rtt, sl,
+						realm_ipa_bits(rd),
+						map_addr, level, wi);
+	}
+
+	ipa = addr_level_mask(map_addr, level - 1L);
+
+	if ((wc->g_tbl != NULL) && (wc->gen == rd->rtt_gen) &&
+	    (wc->level == level) && (wc->ipa == ipa)) {
+		granule_lock(wc->g_tbl, GRANULE_STATE_RTT);
+		wi->g_llt = wc->g_tbl;
+		wi->last_level = level;
+		wi->index = s2_addr_to_idx(map_addr, level);
+		return granule_map(wi->g_llt, RTT_WALK_SLOT(level));
+	}
+
+	granule_lock(rd->s2_ctx.g_rtt, GRANULE_STATE_RTT);
+	s2tt = rtt_walk_lock_unlock_map(rd->s2_ctx.g_rtt, sl,
+					realm_ipa_bits(rd),
+					map_addr, level, wi);
+
+	if (wi->last_level == level) {
+		wc->gen = rd->rtt_gen;
+		wc->ipa = ipa;
+		wc->level = level;
+		wc->g_tbl = wi->g_llt;
+	}
+
+	return s2tt;
+}
+
+/*
+ * Read the s2tte which translates @map_addr in the RTT tree of the realm
+ * described by @rd, without taking any RTT lock. The walk goes down from the
+ * starting level until either a leaf entry or RTT_PAGE_LEVEL is reached.
+ *
+ * The walk registers itself in rd::rtt_readers before sampling rd::rtt_gen,
+ * so that rtt_remove_begin() either sees the walk and waits for it to finish,
+ * or the walk sees the odd generation and gives up. In both cases no RTT is
+ * released while it is being read. Entries are read with acquire semantics,
+ * pairing with the store-release which links a new table in smc_rtt_create(),
+ * so that the entries of a linked table are seen initialized.
+ *
+ * The caller must hold a reference to the realm, which keeps @rd alive, but
+ * does not need to hold the rd granule lock.
+ *
+ * On success, returns true and sets @s2tte and @level to the entry and the
+ * level it was read at. Returns false if the walk conflicted with an update
+ * of the RTT tree, in which case the caller must fall back to a locked walk.
+ */
+bool rtt_read_entry_lockless(struct rd *rd, unsigned long map_addr,
+			     unsigned long *s2tte, long *level)
+{
+	int sl = realm_rtt_starting_level(rd);
+	struct granule *g_tbl = rd->s2_ctx.g_rtt;
+	unsigned long idx, entry = 0UL;
+	bool ret = false;
+	long i;
+
+	assert(map_addr < realm_ipa_size(rd));
+
+	atomic_add_64(&rd->rtt_readers, 1L);
+	dmb(ish);
+
+	if ((SCA_READ64_ACQUIRE(&rd->rtt_gen) & 1UL) != 0UL) {
+		goto out;
+	}
+
+	/* Handle concatenated starting level (SL) tables */
+	idx = s2_sl_addr_to_idx(map_addr, sl, realm_ipa_bits(rd));
+	g_tbl += (idx >> S2TTE_STRIDE);
+
+	for (i = sl; i <= RTT_PAGE_LEVEL; i++) {
+		unsigned long *table;
+
+		table = granule_map(g_tbl, RTT_WALK_SLOT(i));
+		entry = __sca_read64_acquire(
+				&table[s2_addr_to_idx(map_addr, i)]);
+		buffer_unmap(table);
+
+		/*
+		 * A zero entry may be a break-before-make in progress, in
+		 * which case the entry is not meaningful yet.
+		 */
+		if (entry == 0UL) {
+			goto out;
+		}
+
+		if ((i == RTT_PAGE_LEVEL) || !entry_is_table(entry)) {
+			break;
+		}
+
+		g_tbl = find_granule(table_entry_to_phys(entry));
+		if (g_tbl == NULL) {
+			goto out;
+		}
+	}
+
+	*s2tte = entry;
+	*level = i;
+	ret = true;
+out:
+	(void)atomic_load_add_release_64(&rd->rtt_readers, -1L);
+	return ret;
+}
+
 /*
  * Creates a value which can be OR'd with an s2tte to set RIPAS=@ripas.
  */
@@ -765,39 +1074,65 @@ bool addr_is_level_aligned(unsigned long addr, long level)
 	return (addr == addr_level_mask(addr, level));
 }
 
-typedef bool (*s2tte_type_checker)(unsigned long s2tte);
+/* Number of s2ttes compared between two tests of the scan result */
+#define S2TT_SCAN_UNROLL	8U
+
+COMPILER_ASSERT((S2TTES_PER_S2TT % S2TT_SCAN_UNROLL) == 0U);
+
+/*
+ * Returns true if the bits selected by @mask are equal to those of @expected
+ * in all s2ttes of @table, @expected being advanced by @stride for each s2tte.
+ *
+ * Rather than testing the s2ttes one by one, the differences are accumulated
+ * over S2TT_SCAN_UNROLL s2ttes (one cache line) and tested once.
+ */
+static inline bool __table_scan(unsigned long *table, unsigned long mask,
+				unsigned long expected, unsigned long stride)
+{
+	unsigned long diff = 0UL;
+	unsigned int i, j;
+
+	RTT_TABLE_SCAN_START();
+
+	for (i = 0U; (i < S2TTES_PER_S2TT) && (diff == 0UL);
+	     i += S2TT_SCAN_UNROLL) {
+		for (j = 0U; j < S2TT_SCAN_UNROLL; j++) {
+			diff |= (s2tte_read(&table[i + j]) ^ expected) & mask;
+			expected += stride;
+		}
+	}
+
+	RTT_TABLE_SCAN_STOP();
 
+	return (diff == 0UL);
+}
+
+/*
+ * Returns true if all s2ttes in @table are invalid with HIPAS=@hipas. If
+ * @ripas_ptr is not NULL, they must also have the same RIPAS, which is
+ * returned in @ripas_ptr.
+ */
 static bool __table_is_uniform_block(unsigned long *table,
-			      s2tte_type_checker s2tte_is_x,
-			      enum ripas *ripas_ptr)
+				     unsigned long hipas,
+				     enum ripas *ripas_ptr)
 {
 	unsigned long s2tte = s2tte_read(&table[0]);
-	enum ripas ripas;
-	unsigned int i;
+	unsigned long mask = DESC_TYPE_MASK | S2TTE_INVALID_HIPAS_MASK;
 
-	if (!s2tte_is_x(s2tte)) {
+	if (!s2tte_has_hipas(s2tte, hipas)) {
 		return false;
 	}
 
 	if (ripas_ptr != NULL) {
-		ripas = s2tte_get_ripas(s2tte);
+		mask |= S2TTE_INVALID_RIPAS_MASK;
 	}
 
-	for (i = 1U; i < S2TTES_PER_S2TT; i++) {
-		s2tte = s2tte_read(&table[i]);
-
-		if (!s2tte_is_x(s2tte)) {
-			return false;
-		}
-
-		if ((ripas_ptr != NULL) &&
-		    (s2tte_get_ripas(s2tte) != ripas)) {
-			return false;
-		}
+	if (!__table_scan(table, mask, s2tte, 0UL)) {
+		return false;
 	}
 
 	if (ripas_ptr != NULL) {
-		*ripas_ptr = ripas;
+		*ripas_ptr = s2tte_get_ripas(s2tte);
 	}
 
 	return true;
@@ -811,7 +1146,8 @@ static bool __table_is_uniform_block(unsigned long *table,
  */
 bool table_is_unassigned_block(unsigned long *table, enum ripas *ripas)
 {
-	return __table_is_uniform_block(table, s2tte_is_unassigned, ripas);
+	return __table_is_uniform_block(table, S2TTE_INVALID_HIPAS_UNASSIGNED,
+					ripas);
 }
 
 /*
@@ -819,44 +1155,38 @@ bool table_is_unassigned_block(unsigned long *table, enum ripas *ripas)
  */
 bool table_is_destroyed_block(unsigned long *table)
 {
-	return __table_is_uniform_block(table, s2tte_is_destroyed, NULL);
+	return __table_is_uniform_block(table, S2TTE_INVALID_HIPAS_DESTROYED,
+					NULL);
 }
 
 typedef bool (*s2tte_type_level_checker)(unsigned long s2tte, long level);
 
+/*
+ * Returns true if all s2ttes in @table satisfy @s2tte_is_x and refer to a
+ * contiguous block of granules aligned to @level - 1.
+ *
+ * @type_mask selects the s2tte bits which @s2tte_is_x depends on. Only the
+ * first s2tte is passed to @s2tte_is_x, the others must have the same bits in
+ * @type_mask. As the block is aligned, the PA of the i-th s2tte is obtained
+ * by adding i * map size to the PA of the first one.
+ */
 static bool __table_maps_block(unsigned long *table,
 			       long level,
-			       s2tte_type_level_checker s2tte_is_x)
+			       s2tte_type_level_checker s2tte_is_x,
+			       unsigned long type_mask)
 {
-	unsigned long base_pa;
-	unsigned long map_size = s2tte_map_size(level);
 	unsigned long s2tte = s2tte_read(&table[0]);
-	unsigned int i;
 
 	if (!s2tte_is_x(s2tte, level)) {
 		return false;
 	}
 
-	base_pa = s2tte_pa(s2tte, level);
-	if (!addr_is_level_aligned(base_pa, level - 1L)) {
+	if (!addr_is_level_aligned(s2tte_pa(s2tte, level), level - 1L)) {
 		return false;
 	}
 
-	for (i = 1U; i < S2TTES_PER_S2TT; i++) {
-		unsigned long expected_pa = base_pa + (i * map_size);
-
-		s2tte = s2tte_read(&table[i]);
-
-		if (!s2tte_is_x(s2tte, level)) {
-			return false;
-		}
-
-		if (s2tte_pa(s2tte, level) != expected_pa) {
-			return false;
-		}
-	}
-
-	return true;
+	return __table_scan(table, type_mask | addr_level_mask(~0UL, level),
+			    s2tte, s2tte_map_size(level));
 }
 
 /*
@@ -865,7 +1195,8 @@ static bool __table_maps_block(unsigned long *table,
  */
 bool table_maps_assigned_block(unsigned long *table, long level)
 {
-	return __table_maps_block(table, level, s2tte_is_assigned);
+	return __table_maps_block(table, level, s2tte_is_assigned,
+				  DESC_TYPE_MASK | S2TTE_INVALID_HIPAS_MASK);
 }
 
 /*
@@ -874,7 +1205,8 @@ bool table_maps_assigned_block(unsigned long *table, long level)
  */
 bool table_maps_valid_block(unsigned long *table, long level)
 {
-	return __table_maps_block(table, level, s2tte_is_valid);
+	return __table_maps_block(table, level, s2tte_is_valid,
+				  DESC_TYPE_MASK | S2TTE_NS);
 }
 
 /*
@@ -883,5 +1215,6 @@ bool table_maps_valid_block(unsigned long *table, long level)
  */
 bool table_maps_valid_ns_block(unsigned long *table, long level)
 {
-	return __table_maps_block(table, level, s2tte_is_valid_ns);
+	return __table_maps_block(table, level, s2tte_is_valid_ns,
+				  DESC_TYPE_MASK | S2TTE_NS);
 }
@@ -0,0 +1,485 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <arch_helpers.h>
+#include <asc.h>
+#include <assert.h>
+#include <buffer.h>
+#include <debug.h>
+#include <granule.h>
+#include <realm.h>
+#include <smmu.h>
+#include <spinlock.h>
+#include <status.h>
+#include <table.h>
+
+/*
+ * Maximum number of entries cleared by a single call to smmu_stream_unmap(),
+ * which bounds the time spent with smmu_lock held.
+ */
+#define SMMU_UNMAP_MAX_ENTRIES	512U
+
+/*
+ * Stage 2 translation tables of a StreamID, built by the RMM from granules
+ * delegated by the Host.
+ *
+ * @g_tables[0] is the root table. The first @nr_linked tables are linked in
+ * the table tree, the others are zeroed and used when a new table is needed.
+ * The stream holds a reference on each of its tables, which are in the RTT
+ * state, and on the RD of the realm which owns the stream.
+ */
+struct smmu_stream {
+	bool valid;
+	unsigned int sid;
+	unsigned int vmid;
+	struct granule *g_rd;
+	unsigned int nr_tables;
+	unsigned int nr_linked;
+	struct granule *g_tables[SMMU_STREAM_MAX_TABLES];
+};
+
+/*
+ * Protects smmu_streams[] and the tables of the streams. It is acquired after
+ * the RD granule lock and before the table granule locks.
+ */
+static spinlock_t smmu_lock;
+static struct smmu_stream smmu_streams[SMMU_MAX_STREAMS];
+
+static struct smmu_stream *find_stream(unsigned int sid)
+{
+	for (unsigned int i = 0U; i < SMMU_MAX_STREAMS; i++) {
+		if (smmu_streams[i].valid && (smmu_streams[i].sid == sid)) {
+			return &smmu_streams[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void smmu_inv_batch_init(struct smmu_inv_batch *batch,
+				unsigned int vmid)
+{
+	batch->vmid = vmid;
+	batch->nr_cmds = 0U;
+	batch->vmall = false;
+}
+
+/*
+ * Records the invalidation of the SMMU TLB entries of the leaf entry which
+ * translates @iova. One entry of the batch is kept for the CMD_SYNC.
+ */
+static void smmu_inv_batch_add(struct smmu_inv_batch *batch,
+			       unsigned long iova)
+{
+	struct asc_smmu_cmd *cmd;
+
+	if (batch->vmall) {
+		return;
+	}
+
+	if (batch->nr_cmds == (SMMU_INV_BATCH_CMDS - 1U)) {
+		batch->vmall = true;
+		return;
+	}
+
+	cmd = &batch->cmds[batch->nr_cmds++];
+	cmd->dw0 = SMMU_CMD_TLBI_S2_IPA |
+		   ((unsigned long)batch->vmid << SMMU_CMD_VMID_SHIFT);
+	cmd->dw1 = SMMU_CMD_LEAF | (iova & SMMU_CMD_ADDR_MASK);
+}
+
+static void smmu_inv_batch_flush(struct smmu_inv_batch *batch)
+{
+	struct asc_smmu_cmd *cmd;
+
+	if (batch->vmall) {
+		cmd = &batch->cmds[0];
+		cmd->dw0 = SMMU_CMD_TLBI_S12_VMALL |
+			   ((unsigned long)batch->vmid << SMMU_CMD_VMID_SHIFT);
+		cmd->dw1 = 0UL;
+		batch->nr_cmds = 1U;
+	} else if (batch->nr_cmds == 0U) {
+		return;
+	}
+
+	cmd = &batch->cmds[batch->nr_cmds++];
+	cmd->dw0 = SMMU_CMD_SYNC;
+	cmd->dw1 = 0UL;
+
+	if (!asc_smmu_cmd_batch(batch->cmds, batch->nr_cmds)) {
+		panic();
+	}
+
+	smmu_inv_batch_init(batch, batch->vmid);
+}
+
+static unsigned long smmu_addr_to_idx(unsigned long iova, long level)
+{
+	unsigned long lsb = ((unsigned long)(RTT_PAGE_LEVEL - level) *
+				S2TTE_STRIDE) + GRANULE_SHIFT;
+
+	return (iova >> lsb) & (S2TTES_PER_S2TT - 1UL);
+}
+
+/*
+ * Walk the tables of @st until level @level using @iova. The walk stops at
+ * the first entry which is not a table entry. If @create is true, a table
+ * taken from the tables of the stream which are not linked yet is linked in
+ * place of an invalid entry, if any is left.
+ *
+ * Returns the table at the last level reached, mapped in SLOT_RTT, which is
+ * also stored in @last_level.
+ */
+static unsigned long *smmu_walk(struct smmu_stream *st, unsigned long iova,
+				long level, bool create, long *last_level)
+{
+	struct granule *g_tbl = st->g_tables[0];
+	long l;
+
+	for (l = SMMU_S2_START_LEVEL; l < level; l++) {
+		unsigned long *table = granule_map(g_tbl, SLOT_RTT);
+		unsigned long idx = smmu_addr_to_idx(iova, l);
+		unsigned long s2tte = s2tte_read(&table[idx]);
+
+		if (s2tte_is_table(s2tte, l)) {
+			g_tbl = addr_to_granule(s2tte_pa_table(s2tte, l));
+		} else if (create && (s2tte == 0UL) &&
+			   (st->nr_linked < st->nr_tables)) {
+			g_tbl = st->g_tables[st->nr_linked++];
+			s2tte_write(&table[idx],
+				    s2tte_create_table(granule_addr(g_tbl), l));
+		} else {
+			*last_level = l;
+			return table;
+		}
+
+		buffer_unmap(table);
+	}
+
+	*last_level = level;
+	return granule_map(g_tbl, SLOT_RTT);
+}
+
+/*
+ * Registers the stage 2 tables of StreamID @sid, owned by the realm whose RD
+ * is @g_rd and which uses @vmid, with @g_root as root table, and hands them
+ * to EL3.
+ *
+ * @g_rd and @g_root must be locked, @g_root in the DELEGATED state. On
+ * success, @g_root is in the RTT state and the stream holds a reference on
+ * @g_rd, which the caller must take.
+ */
+unsigned long smmu_stream_create(unsigned int sid, struct granule *g_rd,
+				 unsigned int vmid, struct granule *g_root)
+{
+	struct smmu_stream *st = NULL;
+	unsigned long ret;
+
+	spinlock_acquire(&smmu_lock);
+
+	if (find_stream(sid) != NULL) {
+		ret = RMI_ERROR_IN_USE;
+		goto out;
+	}
+
+	for (unsigned int i = 0U; i < SMMU_MAX_STREAMS; i++) {
+		if (!smmu_streams[i].valid) {
+			st = &smmu_streams[i];
+			break;
+		}
+	}
+
+	if (st == NULL) {
+		ret = RMI_ERROR_IN_USE;
+		goto out;
+	}
+
+	granule_scrub_on_use(g_root, SLOT_DELEGATED);
+	dsb(ish);
+
+	if (asc_smmu_s2_attach(sid, granule_addr(g_root), vmid,
+			       SMMU_S2_IOVA_BITS) != 0UL) {
+		ret = RMI_ERROR_INPUT;
+		goto out;
+	}
+
+	__granule_get(g_root);
+	granule_set_state(g_root, GRANULE_STATE_RTT);
+
+	st->sid = sid;
+	st->vmid = vmid;
+	st->g_rd = g_rd;
+	st->g_tables[0] = g_root;
+	st->nr_tables = 1U;
+	st->nr_linked = 1U;
+	st->valid = true;
+	ret = RMI_SUCCESS;
+
+out:
+	spinlock_release(&smmu_lock);
+	return ret;
+}
+
+/*
+ * Detaches the stage 2 tables of StreamID @sid, owned by the realm whose RD is
+ * @g_rd, from the SMMU and releases all its table granules to the DELEGATED
+ * state. @g_rd must be locked, the caller drops the reference held by the
+ * stream on success.
+ */
+unsigned long smmu_stream_destroy(unsigned int sid, struct granule *g_rd)
+{
+	struct smmu_inv_batch batch;
+	struct smmu_stream *st;
+
+	spinlock_acquire(&smmu_lock);
+
+	st = find_stream(sid);
+	if ((st == NULL) || (st->g_rd != g_rd)) {
+		spinlock_release(&smmu_lock);
+		return RMI_ERROR_INPUT;
+	}
+
+	asc_smmu_s2_detach(sid);
+
+	smmu_inv_batch_init(&batch, st->vmid);
+	batch.vmall = true;
+	smmu_inv_batch_flush(&batch);
+
+	for (unsigned int i = 0U; i < st->nr_tables; i++) {
+		struct granule *g_tbl = st->g_tables[i];
+
+		granule_lock(g_tbl, GRANULE_STATE_RTT);
+		__granule_put(g_tbl);
+		granule_memzero(g_tbl, SLOT_RTT);
+		granule_unlock_transition(g_tbl, GRANULE_STATE_DELEGATED);
+	}
+
+	st->valid = false;
+
+	spinlock_release(&smmu_lock);
+	return RMI_SUCCESS;
+}
+
+/*
+ * Returns the RD of the realm which owns StreamID @sid, or NULL if the
+ * StreamID has no stage 2 tables. The RD may be released as soon as the
+ * function returns, so the caller must check its state once it is locked.
+ */
+struct granule *smmu_stream_rd(unsigned int sid)
+{
+	struct smmu_stream *st;
+	struct granule *g_rd = NULL;
+
+	spinlock_acquire(&smmu_lock);
+
+	st = find_stream(sid);
+	if (st != NULL) {
+		g_rd = st->g_rd;
+	}
+
+	spinlock_release(&smmu_lock);
+	return g_rd;
+}
+
+/*
+ * Adds @g_tbl, locked in the DELEGATED state, to the tables which can be
+ * linked in the table tree of StreamID @sid, which must be owned by the realm
+ * whose RD is @g_rd.
+ */
+unsigned long smmu_stream_table_add(unsigned int sid, struct granule *g_rd,
+				    struct granule *g_tbl)
+{
+	struct smmu_stream *st;
+	unsigned long ret;
+
+	spinlock_acquire(&smmu_lock);
+
+	st = find_stream(sid);
+	if ((st == NULL) || (st->g_rd != g_rd) ||
+	    (st->nr_tables == SMMU_STREAM_MAX_TABLES)) {
+		ret = RMI_ERROR_INPUT;
+		goto out;
+	}
+
+	/* The table must be zero before it is seen by the SMMU walker */
+	granule_scrub_on_use(g_tbl, SLOT_DELEGATED);
+	dsb(ish);
+
+	__granule_get(g_tbl);
+	granule_set_state(g_tbl, GRANULE_STATE_RTT);
+	st->g_tables[st->nr_tables++] = g_tbl;
+	ret = RMI_SUCCESS;
+
+out:
+	spinlock_release(&smmu_lock);
+	return ret;
+}
+
+/*
+ * Maps the @nr_runs runs of @runs in the stage 2 tables of StreamID @sid,
+ * which must be owned by the realm whose RD is @g_rd, using the IPA of each
+ * run as IOVA. Block mappings are used where the IOVA, the PA and the size
+ * allow it, and page mappings otherwise.
+ *
+ * The caller must hold the lock of @g_rd, which keeps the translation of
+ * @runs valid. The number of bytes mapped is returned in @mapped.
+ *
+ * Returns RMI_ERROR_RTT with the level reached by the walk if a table is
+ * needed and none is left, or if the IOVA is already mapped differently.
+ */
+unsigned long smmu_stream_map(unsigned int sid, struct granule *g_rd,
+			      const struct s2_walk_run *runs,
+			      unsigned int nr_runs,
+			      unsigned long *mapped)
+{
+	struct smmu_stream *st;
+	unsigned long ret = RMI_SUCCESS;
+
+	*mapped = 0UL;
+
+	spinlock_acquire(&smmu_lock);
+
+	st = find_stream(sid);
+	if ((st == NULL) || (st->g_rd != g_rd)) {
+		ret = RMI_ERROR_INPUT;
+		goto out;
+	}
+
+	for (unsigned int r = 0U; r < nr_runs; r++) {
+		unsigned long off = 0UL;
+
+		while (off < runs[r].size) {
+			unsigned long iova = runs[r].ipa + off;
+			unsigned long pa = runs[r].pa + off;
+			unsigned long *table, s2tte, idx, size;
+			long level = RTT_PAGE_LEVEL, last_level;
+
+			if ((iova >> SMMU_S2_IOVA_BITS) != 0UL) {
+				ret = RMI_ERROR_INPUT;
+				goto out;
+			}
+
+			size = s2tte_map_size(RTT_MIN_BLOCK_LEVEL);
+			if (addr_is_level_aligned(iova, RTT_MIN_BLOCK_LEVEL) &&
+			    addr_is_level_aligned(pa, RTT_MIN_BLOCK_LEVEL) &&
+			    ((runs[r].size - off) >= size)) {
+				level = RTT_MIN_BLOCK_LEVEL;
+			}
+
+			table = smmu_walk(st, iova, level, true, &last_level);
+			idx = smmu_addr_to_idx(iova, last_level);
+			s2tte = s2tte_read(&table[idx]);
+
+			/* A table already covers the block, use pages */
+			if ((last_level == level) && (level != RTT_PAGE_LEVEL) &&
+			    s2tte_is_table(s2tte, level)) {
+				buffer_unmap(table);
+				table = smmu_walk(st, iova, RTT_PAGE_LEVEL,
+						  true, &last_level);
+				level = RTT_PAGE_LEVEL;
+				idx = smmu_addr_to_idx(iova, last_level);
+				s2tte = s2tte_read(&table[idx]);
+			}
+
+			if ((last_level != level) ||
+			    ((s2tte != 0UL) &&
+			     (s2tte != s2tte_create_valid(pa, level)))) {
+				buffer_unmap(table);
+				ret = pack_return_code(RMI_ERROR_RTT,
+						       (unsigned int)last_level);
+				goto out;
+			}
+
+			s2tte_write(&table[idx], s2tte_create_valid(pa, level));
+			buffer_unmap(table);
+
+			size = s2tte_map_size((int)level);
+			off += size;
+			*mapped += size;
+		}
+	}
+
+out:
+	spinlock_release(&smmu_lock);
+	return ret;
+}
+
+/*
+ * Removes the mappings of [@base, @top) from the stage 2 tables of StreamID
+ * @sid, which must be owned by the realm whose RD is @g_rd, and invalidates
+ * the SMMU TLB entries. At most SMMU_UNMAP_MAX_ENTRIES entries are cleared,
+ * the address from which the operation is to be resumed is returned in @next. Tables are kept linked until the stream is destroyed.
+ *
+ * Returns RMI_ERROR_RTT with the level of the entry if a block mapping is
+ * only partially covered by the range.
+ */
+unsigned long smmu_stream_unmap(unsigned int sid,
+				struct granule *g_rd,
+				unsigned long base,
+				unsigned long top,
+				unsigned long *next)
+{
+	struct smmu_inv_batch batch;
+	struct smmu_stream *st;
+	unsigned long ret = RMI_SUCCESS;
+	unsigned long addr = base;
+	unsigned int budget = SMMU_UNMAP_MAX_ENTRIES;
+
+	*next = base;
+
+	if (!GRANULE_ALIGNED(base) || !GRANULE_ALIGNED(top) || (top <= base) ||
+	    ((top - 1UL) >> SMMU_S2_IOVA_BITS) != 0UL) {
+		return RMI_ERROR_INPUT;
+	}
+
+	spinlock_acquire(&smmu_lock);
+
+	st = find_stream(sid);
+	if ((st == NULL) || (st->g_rd != g_rd)) {
+		spinlock_release(&smmu_lock);
+		return RMI_ERROR_INPUT;
+	}
+
+	smmu_inv_batch_init(&batch, st->vmid);
+
+	while ((addr < top) && (budget != 0U)) {
+		unsigned long *table, s2tte, idx, size;
+		long level;
+
+		table = smmu_walk(st, addr, RTT_PAGE_LEVEL, false, &level);
+		idx = smmu_addr_to_idx(addr, level);
+		s2tte = s2tte_read(&table[idx]);
+		size = s2tte_map_size((int)level);
+
+		if (s2tte == 0UL) {
+			/* Nothing is mapped up to the end of the entry */
+			buffer_unmap(table);
+			addr = (addr & ~(size - 1UL)) + size;
+			continue;
+		}
+
+		if (!addr_is_level_aligned(addr, level) ||
+		    ((top - addr) < size)) {
+			buffer_unmap(table);
+			ret = pack_return_code(RMI_ERROR_RTT,
+					       (unsigned int)level);
+			break;
+		}
+
+		s2tte_write(&table[idx], 0UL);
+		buffer_unmap(table);
+
+		smmu_inv_batch_add(&batch, addr);
+		addr += size;
+		budget--;
+	}
+
+	smmu_inv_batch_flush(&batch);
+
+	spinlock_release(&smmu_lock);
+
+	*next = (addr < top) ? addr : top;
+	return ret;
+}
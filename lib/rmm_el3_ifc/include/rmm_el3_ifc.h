@@ -78,14 +78,33 @@ void rmm_el3_ifc_release_shared_buf(void);
  * Boot Manifest functions and structures.
  ****************************************************************************/
 
-/* Boot manifest core structure as per v0.1 */
+/* DRAM bank structure */
+struct ns_dram_bank {
+	uintptr_t base;	/* Base address */
+	uint64_t size;	/* Size of bank */
+};
+
+/*
+ * DRAM layout info structure. The sum of all the fields of the structure and
+ * of all the fields of the banks[] array, including @checksum, must be zero.
+ */
+struct ns_dram_info {
+	uint64_t num_banks;		/* Number of DRAM banks */
+	struct ns_dram_bank *banks;	/* Pointer to ns_dram_bank[] */
+	uint64_t checksum;		/* Checksum of ns_dram_info data */
+};
+
+/* Boot manifest core structure as per v0.2 */
 struct rmm_core_manifest {
-	uint32_t version;	/* Manifest version */
-	uintptr_t plat_data;	/* Manifest platform data */
+	uint32_t version;		/* Manifest version */
+	uint32_t padding;		/* RES0 */
+	uintptr_t plat_data;		/* Manifest platform data */
+	struct ns_dram_info plat_dram;	/* Platform DRAM data (v0.2) */
 };
 
 COMPILER_ASSERT(offsetof(struct rmm_core_manifest, version) == 0);
 COMPILER_ASSERT(offsetof(struct rmm_core_manifest, plat_data) == 8);
+COMPILER_ASSERT(offsetof(struct rmm_core_manifest, plat_dram) == 16);
 
 /*
  * Accessors to the Boot Manifest data.
@@ -102,6 +121,27 @@ unsigned int rmm_el3_ifc_get_manifest_version(void);
  */
 uintptr_t rmm_el3_ifc_get_plat_manifest_pa(void);
 
+/*
+ * Return a pointer to the DRAM layout passed by EL3 Firmware, after validating
+ * it. The banks must be granule aligned, sorted by increasing base address and
+ * must not overlap.
+ *
+ * As for rmm_el3_ifc_get_plat_manifest_pa(), this function can only be called
+ * before the MMU is enabled.
+ *
+ * Args:
+ *	- max_num_banks:	Maximum number of banks supported by the caller.
+ *	- plat_dram_info:	Pointer where the address of the validated
+ *				DRAM layout will be stored.
+ * Return:
+ *	- 0 on success.
+ *	- E_RMM_BOOT_MANIFEST_VERSION_NOT_SUPPORTED if the manifest does not
+ *	  carry the DRAM layout (manifest version older than v0.2).
+ *	- E_RMM_BOOT_MANIFEST_DATA_ERROR if the DRAM layout is not valid.
+ */
+int rmm_el3_ifc_get_dram_data_validated_pa(unsigned long max_num_banks,
+					   struct ns_dram_info **plat_dram_info);
+
 /****************************************************************************
  * RMM-EL3 Runtime APIs
  ***************************************************************************/
@@ -209,13 +249,15 @@ int rmm_el3_ifc_get_platform_token(uintptr_t buf, size_t buflen,
  * The Minor version value for the Boot Manifest supported by this
  * implementation of RMM.
  */
-#define RMM_EL3_MANIFEST_VERS_MINOR	(U(1))
+#define RMM_EL3_MANIFEST_VERS_MINOR	(U(2))
 
 #define RMM_EL3_MANIFEST_GET_VERS_MAJOR					\
 				RMM_EL3_IFC_GET_VERS_MAJOR
 #define RMM_EL3_MANIFEST_GET_VERS_MINOR					\
 				RMM_EL3_IFC_GET_VERS_MINOR
-#define RMM_EL3_MANIFEST_VERSION					\
-				RMM_EL3_IFC_SUPPORTED_VERSION
+#define RMM_EL3_MANIFEST_VERSION (					\
+		(((RMM_EL3_MANIFEST_VERS_MAJOR) & 0x7FFF) << 16) |	\
+		((RMM_EL3_MANIFEST_VERS_MINOR) & 0xFFFF)		\
+	)
 
 #endif /* RMM_EL3_IFC_H */
@@ -71,3 +71,55 @@ uintptr_t rmm_el3_ifc_get_plat_manifest_pa(void)
 
 	return local_core_manifest.plat_data;
 }
+
+/* Return the validated DRAM layout received in the boot manifest */
+int rmm_el3_ifc_get_dram_data_validated_pa(unsigned long max_num_banks,
+					   struct ns_dram_info **plat_dram_info)
+{
+	struct ns_dram_info *info = &local_core_manifest.plat_dram;
+	struct ns_dram_bank *bank;
+	unsigned long num_banks, checksum, end = 0UL;
+
+	assert((manifest_processed == true) && (is_mmu_enabled() == false));
+	assert(plat_dram_info != NULL);
+
+	*plat_dram_info = NULL;
+
+	/* The DRAM layout is only present from version v0.2 onwards */
+	if ((RMM_EL3_MANIFEST_GET_VERS_MAJOR(local_core_manifest.version) ==
+							U(0)) &&
+	    (RMM_EL3_MANIFEST_GET_VERS_MINOR(local_core_manifest.version) <
+							U(2))) {
+		return E_RMM_BOOT_MANIFEST_VERSION_NOT_SUPPORTED;
+	}
+
+	num_banks = info->num_banks;
+	if ((num_banks == 0UL) || (num_banks > max_num_banks) ||
+	    (info->banks == NULL)) {
+		return E_RMM_BOOT_MANIFEST_DATA_ERROR;
+	}
+
+	checksum = num_banks + (unsigned long)info->banks + info->checksum;
+	bank = info->banks;
+
+	for (unsigned long i = 0UL; i < num_banks; i++, bank++) {
+		/* Banks must be aligned, sorted and must not overlap */
+		if (!GRANULE_ALIGNED(bank->base) ||
+		    !GRANULE_ALIGNED(bank->size) ||
+		    (bank->size == 0UL) ||
+		    (bank->base < end) ||
+		    ((bank->base + bank->size) < bank->base)) {
+			return E_RMM_BOOT_MANIFEST_DATA_ERROR;
+		}
+
+		end = bank->base + bank->size;
+		checksum += bank->base + bank->size;
+	}
+
+	if (checksum != 0UL) {
+		return E_RMM_BOOT_MANIFEST_DATA_ERROR;
+	}
+
+	*plat_dram_info = info;
+	return 0;
+}
@@ -73,7 +73,7 @@
 #define SMC64_PSCI_FNUM_MAX	(U(0x14))
 
 #define SMC64_RMI_FNUM_MIN	(U(0x150))
-#define SMC64_RMI_FNUM_MAX	(U(0x169))
+#define SMC64_RMI_FNUM_MAX	(U(0x178))
 
 #define SMC64_RSI_FNUM_MIN	(U(0x190))
 #define SMC64_RSI_FNUM_MAX	(U(0x1AF))
@@ -140,6 +140,10 @@
 #define SMC_ASC_MARK_SECURE_DEV		SMC64_STD_FID(RMM_EL3, U(8))
 #define SMC_REQUEST_DEVICE_OWNERSHIP SMC64_STD_FID(RMM_EL3, U(11))
 #define SMC_ASC_ATTACH_DEV		SMC64_STD_FID(RMM_EL3, U(10))
+#define SMC_ASC_MARK_BATCH		SMC64_STD_FID(RMM_EL3, U(12))
+#define SMC_ASC_SMMU_S2_ATTACH		SMC64_STD_FID(RMM_EL3, U(13))
+#define SMC_ASC_SMMU_S2_DETACH		SMC64_STD_FID(RMM_EL3, U(14))
+#define SMC_ASC_SMMU_CMD_BATCH		SMC64_STD_FID(RMM_EL3, U(15))
 
 /* ARM ARCH call FIDs */
 #define SMCCC_VERSION			SMC32_ARCH_FID(U(0))
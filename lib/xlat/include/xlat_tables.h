@@ -270,6 +270,31 @@ int xlat_map_memory_page_with_attrs(const struct xlat_table_entry * const table,
 				    const uintptr_t pa,
 				    const uint64_t attrs);
 
+/*
+ * Map the physically contiguous range [pa, pa + size) at [va, va + size) in
+ * the last level table described by @table, using the attributes @attrs.
+ * The contiguous hint is set on every naturally aligned group of entries
+ * which is fully mapped. All the descriptors in the range must be invalid.
+ *
+ * This function returns 0 on success or a negative error code otherwise.
+ */
+int xlat_map_memory_range_with_attrs(
+				const struct xlat_table_entry * const table,
+				const uintptr_t va,
+				const uintptr_t pa,
+				const size_t size,
+				const uint64_t attrs);
+
+/*
+ * Unmap the range [va, va + size) mapped by
+ * xlat_map_memory_range_with_attrs(), with a single TLB synchronization.
+ *
+ * This function returns 0 on success or a negative error code otherwise.
+ */
+int xlat_unmap_memory_range(const struct xlat_table_entry * const table,
+			    const uintptr_t va,
+			    const size_t size);
+
 /*
  * This function finds the descriptor entry on a table given the corresponding
  * table entry structure and the VA for that descriptor.
@@ -189,6 +189,32 @@ void xlat_arch_tlbi_va(uintptr_t va)
 	tlbivae2is(TLBI_ADDR(va));
 }
 
+/*
+ * Above this number of pages, the whole EL2 translation regime is invalidated
+ * instead of issuing one TLBI per page.
+ */
+#define TLBI_VA_RANGE_MAX_PAGES		UL(64)
+
+void xlat_arch_tlbi_va_range(uintptr_t va, size_t size)
+{
+	size_t pages = size >> XLAT_GRANULARITY_SIZE_SHIFT;
+
+	/*
+	 * Ensure the translation table writes have drained into memory before
+	 * invalidating the TLB entries.
+	 */
+	dsb(ishst);
+
+	if (pages > TLBI_VA_RANGE_MAX_PAGES) {
+		tlbialle2is();
+		return;
+	}
+
+	for (size_t i = 0UL; i < pages; i++) {
+		tlbivae2is(TLBI_ADDR(va + (i * PAGE_SIZE)));
+	}
+}
+
 void xlat_arch_tlbi_va_sync(void)
 {
 	/*
@@ -30,6 +30,13 @@ void xlat_arch_tlbi_va(uintptr_t va);
  */
 void xlat_arch_tlbi_va_sync(void);
 
+/*
+ * Invalidate all TLB entries that match the page aligned virtual addresses in
+ * the range [va, va + size). Like xlat_arch_tlbi_va(), it must be followed by
+ * a call to xlat_arch_tlbi_va_sync().
+ */
+void xlat_arch_tlbi_va_range(uintptr_t va, size_t size);
+
 /* Print VA, PA, size and attributes of all regions in the mmap array. */
 void xlat_mmap_print(const struct xlat_ctx *ctx);
 
@@ -417,6 +417,124 @@ int xlat_map_memory_page_with_attrs(const struct xlat_table_entry * const table,
 	return 0;
 }
 
+/*
+ * Number of consecutive last level entries covered by the contiguous hint with
+ * 4KB granularity.
+ */
+#define XLAT_CONT_ENTRIES	UL(16)
+#define XLAT_CONT_SIZE		(XLAT_CONT_ENTRIES * PAGE_SIZE)
+
+/*
+ * Check that [va, va + size) is a non empty, page aligned range fully
+ * described by the last level table @table.
+ */
+static bool xlat_range_in_table(const struct xlat_table_entry * const table,
+				const uintptr_t va,
+				const size_t size)
+{
+	if ((table->level != XLAT_TABLE_LEVEL_MAX) || (size == 0UL) ||
+	    !IS_PAGE_ALIGNED(va) || !IS_PAGE_ALIGNED(size)) {
+		return false;
+	}
+
+	return (xlat_get_pte_from_table(table, va) != NULL) &&
+		(xlat_get_pte_from_table(table, va + size - PAGE_SIZE) != NULL);
+}
+
+int xlat_map_memory_range_with_attrs(
+				const struct xlat_table_entry * const table,
+				const uintptr_t va,
+				const uintptr_t pa,
+				const size_t size,
+				const uint64_t attrs)
+{
+	uint64_t *desc_ptr;
+	size_t pages, i;
+
+	assert(table != NULL);
+
+	if (!xlat_range_in_table(table, va, size) || !IS_PAGE_ALIGNED(pa)) {
+		return -EINVAL;
+	}
+
+	/* Check that the PA range is within boundaries */
+	if ((pa + size - 1UL) > xlat_arch_get_max_supported_pa()) {
+		return -EFAULT;
+	}
+
+	desc_ptr = xlat_get_pte_from_table(table, va);
+	pages = size / PAGE_SIZE;
+
+	/* This function must only be called on invalid descriptors */
+	for (i = 0UL; i < pages; i++) {
+		if (xlat_read_descriptor(&desc_ptr[i]) != INVALID_DESC) {
+			return -EFAULT;
+		}
+	}
+
+	i = 0UL;
+	while (i < pages) {
+		uintptr_t offset = i * PAGE_SIZE;
+		size_t n = 1UL;
+		uint64_t group_attrs = attrs;
+
+		/*
+		 * Use the contiguous hint on the groups of entries where both
+		 * the VA and the PA are aligned to the size of the group.
+		 */
+		if (ALIGNED(va + offset, XLAT_CONT_SIZE) &&
+		    ALIGNED(pa + offset, XLAT_CONT_SIZE) &&
+		    ((pages - i) >= XLAT_CONT_ENTRIES)) {
+			n = XLAT_CONT_ENTRIES;
+			group_attrs |= MT_CONT;
+		}
+
+		for (size_t j = 0UL; j < n; j++) {
+			xlat_write_descriptor(&desc_ptr[i + j],
+				xlat_desc(group_attrs,
+					  pa + offset + (j * PAGE_SIZE),
+					  table->level));
+		}
+
+		i += n;
+	}
+
+	/* Ensure the translation table writes have drained into memory */
+	dsb(ishst);
+	isb();
+
+	return 0;
+}
+
+int xlat_unmap_memory_range(const struct xlat_table_entry * const table,
+			    const uintptr_t va,
+			    const size_t size)
+{
+	uint64_t *desc_ptr;
+	size_t pages;
+
+	assert(table != NULL);
+
+	if (!xlat_range_in_table(table, va, size)) {
+		return -EINVAL;
+	}
+
+	desc_ptr = xlat_get_pte_from_table(table, va);
+	pages = size / PAGE_SIZE;
+
+	for (size_t i = 0UL; i < pages; i++) {
+		xlat_write_descriptor(&desc_ptr[i], INVALID_DESC);
+	}
+
+	/* Invalidate any cached copy of the mappings in the TLBs. */
+	xlat_arch_tlbi_va_range(va, size);
+
+	/* Ensure completion of the invalidation. */
+	xlat_arch_tlbi_va_sync();
+
+	return 0;
+}
+
 /*
  * Return a table entry structure given a context and a VA.
  * The return structure is populated on the retval field.
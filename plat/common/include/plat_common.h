@@ -6,12 +6,15 @@
 #ifndef PLAT_COMMON_H
 #define PLAT_COMMON_H
 
-/* Forward declaration */
+/* Forward declarations */
+struct plat_dram_bank;
 struct xlat_mmap_region;
 
 int plat_cmn_setup(unsigned long x0, unsigned long x1,
 		   unsigned long x2, unsigned long x3,
 		   struct xlat_mmap_region *plat_regions);
 int plat_cmn_warmboot_setup(void);
+int plat_cmn_granule_setup(const struct plat_dram_bank *def_banks,
+			   unsigned long num_def_banks);
 
 #endif /* PLAT_COMMON_H */
@@ -0,0 +1,142 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+#include <plat_common.h>
+#include <platform_api.h>
+#include <rmm_el3_ifc.h>
+#include <stdint.h>
+#include <utils_def.h>
+
+/*
+ * Layout of the struct granules array. Bank i covers the addresses
+ * [base[i], base[i] + (nr_granules[i] * GRANULE_SIZE)) and is mapped to the
+ * indexes [idx_base[i], idx_base[i] + nr_granules[i]).
+ *
+ * Unused banks have nr_granules[i] == 0 and never match a lookup. The lookups
+ * always iterate over PLAT_MAX_DRAM_BANKS entries, without early exit, so that
+ * they are constant time and the compiler can avoid data dependent branches.
+ */
+static struct {
+	unsigned long base[PLAT_MAX_DRAM_BANKS];
+	unsigned long nr_granules[PLAT_MAX_DRAM_BANKS];
+	unsigned long idx_base[PLAT_MAX_DRAM_BANKS];
+	unsigned long num_banks;
+} granule_layout;
+
+int plat_granule_banks_init(const struct plat_dram_bank *banks,
+			    unsigned long num_banks)
+{
+	unsigned long idx = 0UL;
+	unsigned long end = 0UL;
+
+	assert(granule_layout.num_banks == 0UL);
+
+	if ((banks == NULL) || (num_banks == 0UL) ||
+	    (num_banks > PLAT_MAX_DRAM_BANKS)) {
+		return -EINVAL;
+	}
+
+	for (unsigned long i = 0UL; i < num_banks; i++) {
+		unsigned long nr_granules = banks[i].size / GRANULE_SIZE;
+
+		if (!GRANULE_ALIGNED(banks[i].base) ||
+		    !GRANULE_ALIGNED(banks[i].size) ||
+		    (banks[i].base < end)) {
+			return -EINVAL;
+		}
+
+		if (nr_granules > (RMM_MAX_GRANULES - idx)) {
+			WARN("DRAM bank %lu truncated: RMM_MAX_GRANULES too small\n",
+			     i);
+			nr_granules = RMM_MAX_GRANULES - idx;
+		}
+
+		granule_layout.base[i] = banks[i].base;
+		granule_layout.nr_granules[i] = nr_granules;
+		granule_layout.idx_base[i] = idx;
+
+		idx += nr_granules;
+		end = banks[i].base + banks[i].size;
+	}
+
+	granule_layout.num_banks = num_banks;
+
+	return 0;
+}
+
+/*
+ * Setup the granule indexing layer from the DRAM layout passed by EL3 in the
+ * boot manifest. If the boot manifest does not carry the DRAM layout, the
+ * @def_banks provided by the platform are used instead.
+ *
+ * This function must be called during cold boot, before the MMU is enabled.
+ */
+int plat_cmn_granule_setup(const struct plat_dram_bank *def_banks,
+			   unsigned long num_def_banks)
+{
+	struct plat_dram_bank banks[PLAT_MAX_DRAM_BANKS];
+	struct ns_dram_info *dram_info;
+	int ret;
+
+	ret = rmm_el3_ifc_get_dram_data_validated_pa(PLAT_MAX_DRAM_BANKS,
+						     &dram_info);
+	if (ret == E_RMM_BOOT_MANIFEST_VERSION_NOT_SUPPORTED) {
+		VERBOSE("Boot manifest without DRAM layout, using defaults\n");
+		return plat_granule_banks_init(def_banks, num_def_banks);
+	}
+
+	if (ret != 0) {
+		ERROR("%s (%u): Invalid DRAM layout in the boot manifest\n",
+		      __func__, __LINE__);
+		return ret;
+	}
+
+	for (unsigned long i = 0UL; i < dram_info->num_banks; i++) {
+		banks[i].base = dram_info->banks[i].base;
+		banks[i].size = dram_info->banks[i].size;
+	}
+
+	return plat_granule_banks_init(banks, dram_info->num_banks);
+}
+
+unsigned long plat_granule_addr_to_idx(unsigned long addr)
+{
+	unsigned long idx = UINT64_MAX;
+
+	if (!GRANULE_ALIGNED(addr)) {
+		return UINT64_MAX;
+	}
+
+	for (unsigned int i = 0U; i < PLAT_MAX_DRAM_BANKS; i++) {
+		/* Addresses below the base of the bank wrap around */
+		unsigned long offset = (addr - granule_layout.base[i]) /
+								GRANULE_SIZE;
+
+		if (offset < granule_layout.nr_granules[i]) {
+			idx = granule_layout.idx_base[i] + offset;
+		}
+	}
+
+	return idx;
+}
+
+unsigned long plat_granule_idx_to_addr(unsigned long idx)
+{
+	unsigned long addr = UINT64_MAX;
+
+	for (unsigned int i = 0U; i < PLAT_MAX_DRAM_BANKS; i++) {
+		unsigned long offset = idx - granule_layout.idx_base[i];
+
+		if (offset < granule_layout.nr_granules[i]) {
+			addr = granule_layout.base[i] + (offset * GRANULE_SIZE);
+		}
+	}
+
+	assert(addr != UINT64_MAX);
+	return addr;
+}
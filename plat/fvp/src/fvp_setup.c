@@ -6,6 +6,7 @@
 #include <fvp_private.h>
 #include <pl011.h>
 #include <plat_common.h>
+#include <platform_api.h>
 #include <sizes.h>
 #include <xlat_tables.h>
 
@@ -20,6 +21,13 @@ struct xlat_mmap_region plat_regions[] = {
 	{0}
 };
 
+COMPILER_ASSERT(RMM_MAX_GRANULES >= FVP_NR_GRANULES);
+
+/* DRAM layout used when the boot manifest does not provide one */
+static const struct plat_dram_bank fvp_dram_banks[] = {
+	{ FVP_DRAM0_BASE, FVP_DRAM0_SIZE }
+};
+
 /*
  * Local platform setup for RMM.
  *
@@ -63,5 +71,11 @@ void plat_setup(uint64_t x0, uint64_t x1, uint64_t x2, uint64_t x3)
 		panic();
 	}
 
+	/* Initialize the granule indexing layer */
+	if (plat_cmn_granule_setup(fvp_dram_banks,
+				   ARRAY_LEN(fvp_dram_banks)) != 0) {
+		panic();
+	}
+
 	plat_warmboot_setup(x0, x1, x2, x3);
 }
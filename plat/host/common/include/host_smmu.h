@@ -0,0 +1,40 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#ifndef HOST_SMMU_H
+#define HOST_SMMU_H
+
+#include <stdbool.h>
+
+/***********************************************************************
+ * Software model of an SMMU which translates the StreamIDs handed to EL3
+ * by the RMM, for use on the fake_host architecture.
+ **********************************************************************/
+
+/*
+ * Emulate the EL3 side of SMC_ASC_SMMU_S2_ATTACH, SMC_ASC_SMMU_S2_DETACH and
+ * SMC_ASC_SMMU_CMD_BATCH.
+ *
+ * Returns the value returned to the RMM in X0.
+ */
+unsigned long host_smmu_monitor_call(unsigned long id,
+				     unsigned long arg0,
+				     unsigned long arg1,
+				     unsigned long arg2,
+				     unsigned long arg3);
+
+/*
+ * Translate @iova for a DMA access of StreamID @sid, as the SMMU would do.
+ * Translations are cached in a TLB model, which only drops entries on the
+ * invalidation commands passed by the RMM, so that missing invalidations are
+ * observable.
+ *
+ * Returns true and sets @pa if the translation succeeds, false on a
+ * translation fault.
+ */
+bool host_smmu_translate(unsigned int sid, unsigned long iova,
+			 unsigned long *pa);
+
+#endif /* HOST_SMMU_H */
@@ -4,7 +4,9 @@
  */
 
 #include <arch.h>
+#include <host_smmu.h>
 #include <host_utils.h>
+#include <smc.h>
 #include <spinlock.h>
 #include <string.h>
 
@@ -28,12 +30,16 @@ unsigned long host_monitor_call(unsigned long id,
 			unsigned long arg4,
 			unsigned long arg5)
 {
+	switch (id) {
+	case SMC_ASC_SMMU_S2_ATTACH:
+	case SMC_ASC_SMMU_S2_DETACH:
+	case SMC_ASC_SMMU_CMD_BATCH:
+		return host_smmu_monitor_call(id, arg0, arg1, arg2, arg3);
+	default:
+		break;
+	}
+
 	/* Avoid MISRA C:2102-2.7 warnings */
-	(void)id;
-	(void)arg0;
-	(void)arg1;
-	(void)arg2;
-	(void)arg3;
 	(void)arg4;
 	(void)arg5;
 	return 0UL;
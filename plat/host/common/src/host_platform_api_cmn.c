@@ -7,6 +7,7 @@
 #include <host_defs.h>
 #include <host_utils.h>
 #include <plat_common.h>
+#include <platform_api.h>
 #include <stdint.h>
 #include <xlat_tables.h>
 
@@ -49,27 +50,20 @@ void plat_warmboot_setup(uint64_t x0, uint64_t x1,
 void plat_setup(uint64_t x0, uint64_t x1,
 		uint64_t x2, uint64_t x3)
 {
+	struct plat_dram_bank host_dram_bank = {
+		.base = host_util_get_granule_base(),
+		.size = HOST_MEM_SIZE
+	};
+
 	/* Initialize xlat table */
 	if (plat_cmn_setup(x0, x1, x2, x3, plat_regions) != 0) {
 		panic();
 	}
 
-	plat_warmboot_setup(x0, x1, x2, x3);
-}
-
-unsigned long plat_granule_addr_to_idx(unsigned long addr)
-{
-	if (!(GRANULE_ALIGNED(addr) &&
-		(addr < (host_util_get_granule_base() + HOST_MEM_SIZE))) &&
-		(addr >= host_util_get_granule_base())) {
-		return UINT64_MAX;
+	/* Initialize the granule indexing layer */
+	if (plat_cmn_granule_setup(&host_dram_bank, 1UL) != 0) {
+		panic();
 	}
 
-	return (addr - host_util_get_granule_base()) / GRANULE_SIZE;
-}
-
-unsigned long plat_granule_idx_to_addr(unsigned long idx)
-{
-	assert(idx < HOST_NR_GRANULES);
-	return host_util_get_granule_base() + (idx * GRANULE_SIZE);
+	plat_warmboot_setup(x0, x1, x2, x3);
 }
@@ -0,0 +1,237 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <asc.h>
+#include <host_smmu.h>
+#include <smc.h>
+#include <smmu.h>
+#include <table.h>
+#include <utils_def.h>
+
+#define HOST_SMMU_MAX_STREAMS	16U
+#define HOST_SMMU_TLB_ENTRIES	64U
+
+#define HOST_SMMU_DESC_MASK	0x3UL
+#define HOST_SMMU_DESC_BLOCK	0x1UL
+#define HOST_SMMU_DESC_TABLE	0x3UL
+#define HOST_SMMU_DESC_PAGE	0x3UL
+#define HOST_SMMU_OA_MASK	0x0000FFFFFFFFF000UL
+
+#define HOST_SMMU_CMD_OPCODE_MASK	0xFFUL
+#define HOST_SMMU_CMD_VMID_MASK		0xFFFFUL
+
+/* Stream table entry */
+struct host_smmu_ste {
+	bool valid;
+	unsigned int sid;
+	unsigned int vmid;
+	unsigned long root;
+	unsigned int ipa_bits;
+};
+
+struct host_smmu_tlb_entry {
+	bool valid;
+	unsigned int vmid;
+	unsigned long iova;
+	unsigned long pa;
+	unsigned long size;
+};
+
+static struct host_smmu_ste host_smmu_stes[HOST_SMMU_MAX_STREAMS];
+static struct host_smmu_tlb_entry host_smmu_tlb[HOST_SMMU_TLB_ENTRIES];
+static unsigned int host_smmu_tlb_next;
+
+static struct host_smmu_ste *find_ste(unsigned int sid)
+{
+	for (unsigned int i = 0U; i < HOST_SMMU_MAX_STREAMS; i++) {
+		if (host_smmu_stes[i].valid && (host_smmu_stes[i].sid == sid)) {
+			return &host_smmu_stes[i];
+		}
+	}
+
+	return NULL;
+}
+
+static unsigned long host_smmu_attach(unsigned int sid, unsigned long root,
+				      unsigned int vmid, unsigned int ipa_bits)
+{
+	struct host_smmu_ste *ste = find_ste(sid);
+
+	if (ste == NULL) {
+		for (unsigned int i = 0U; i < HOST_SMMU_MAX_STREAMS; i++) {
+			if (!host_smmu_stes[i].valid) {
+				ste = &host_smmu_stes[i];
+				break;
+			}
+		}
+	}
+
+	if ((ste == NULL) || (ipa_bits != SMMU_S2_IOVA_BITS)) {
+		return 1UL;
+	}
+
+	ste->sid = sid;
+	ste->root = root;
+	ste->vmid = vmid;
+	ste->ipa_bits = ipa_bits;
+	ste->valid = true;
+	return 0UL;
+}
+
+static unsigned long host_smmu_detach(unsigned int sid)
+{
+	struct host_smmu_ste *ste = find_ste(sid);
+
+	if (ste == NULL) {
+		return 1UL;
+	}
+
+	ste->valid = false;
+	return 0UL;
+}
+
+static void host_smmu_tlb_invalidate(unsigned int vmid, bool all,
+				     unsigned long iova)
+{
+	for (unsigned int i = 0U; i < HOST_SMMU_TLB_ENTRIES; i++) {
+		struct host_smmu_tlb_entry *e = &host_smmu_tlb[i];
+
+		if (!e->valid || (e->vmid != vmid)) {
+			continue;
+		}
+
+		if (all || ((iova >= e->iova) && (iova < (e->iova + e->size)))) {
+			e->valid = false;
+		}
+	}
+}
+
+static unsigned long host_smmu_cmd_batch(unsigned long buf_pa,
+					 unsigned long count)
+{
+	struct asc_smmu_cmd *cmds = (struct asc_smmu_cmd *)buf_pa;
+
+	if (count > ASC_SMMU_CMD_MAX_ENTRIES) {
+		return 1UL;
+	}
+
+	for (unsigned long i = 0UL; i < count; i++) {
+		unsigned long opcode = cmds[i].dw0 & HOST_SMMU_CMD_OPCODE_MASK;
+		unsigned int vmid = (unsigned int)((cmds[i].dw0 >>
+			SMMU_CMD_VMID_SHIFT) & HOST_SMMU_CMD_VMID_MASK);
+
+		switch (opcode) {
+		case SMMU_CMD_TLBI_S2_IPA:
+			host_smmu_tlb_invalidate(vmid, false,
+					cmds[i].dw1 & SMMU_CMD_ADDR_MASK);
+			break;
+		case SMMU_CMD_TLBI_S12_VMALL:
+			host_smmu_tlb_invalidate(vmid, true, 0UL);
+			break;
+		case SMMU_CMD_SYNC:
+			break;
+		default:
+			/* Command not supported by the model */
+			return 1UL;
+		}
+	}
+
+	return 0UL;
+}
+
+unsigned long host_smmu_monitor_call(unsigned long id,
+				     unsigned long arg0,
+				     unsigned long arg1,
+				     unsigned long arg2,
+				     unsigned long arg3)
+{
+	switch (id) {
+	case SMC_ASC_SMMU_S2_ATTACH:
+		return host_smmu_attach((unsigned int)arg0, arg1,
+					(unsigned int)arg2,
+					(unsigned int)arg3);
+	case SMC_ASC_SMMU_S2_DETACH:
+		return host_smmu_detach((unsigned int)arg0);
+	case SMC_ASC_SMMU_CMD_BATCH:
+		return host_smmu_cmd_batch(arg0, arg1);
+	default:
+		return 1UL;
+	}
+}
+
+/*
+ * Walk the stage 2 tables of @ste for @iova. On fake_host, physical addresses
+ * are directly accessible.
+ */
+static bool host_smmu_walk(struct host_smmu_ste *ste, unsigned long iova,
+			   struct host_smmu_tlb_entry *res)
+{
+	unsigned long table = ste->root;
+
+	if ((iova >> ste->ipa_bits) != 0UL) {
+		return false;
+	}
+
+	for (long level = SMMU_S2_START_LEVEL; level <= RTT_PAGE_LEVEL;
+	     level++) {
+		unsigned long size = s2tte_map_size((int)level);
+		unsigned long idx = (iova / size) %
+				    (unsigned long)S2TTES_PER_S2TT;
+		unsigned long desc = ((unsigned long *)table)[idx];
+		unsigned long type = desc & HOST_SMMU_DESC_MASK;
+
+		if ((level < RTT_PAGE_LEVEL) && (type == HOST_SMMU_DESC_TABLE)) {
+			table = desc & HOST_SMMU_OA_MASK;
+			continue;
+		}
+
+		if (((level == RTT_PAGE_LEVEL) &&
+		     (type == HOST_SMMU_DESC_PAGE)) ||
+		    ((level != RTT_PAGE_LEVEL) && (level != 0L) &&
+		     (type == HOST_SMMU_DESC_BLOCK))) {
+			res->iova = iova & ~(size - 1UL);
+			res->pa = desc & HOST_SMMU_OA_MASK & ~(size - 1UL);
+			res->size = size;
+			return true;
+		}
+
+		break;
+	}
+
+	return false;
+}
+
+bool host_smmu_translate(unsigned int sid, unsigned long iova,
+			 unsigned long *pa)
+{
+	struct host_smmu_ste *ste = find_ste(sid);
+	struct host_smmu_tlb_entry entry;
+
+	if (ste == NULL) {
+		return false;
+	}
+
+	for (unsigned int i = 0U; i < HOST_SMMU_TLB_ENTRIES; i++) {
+		struct host_smmu_tlb_entry *e = &host_smmu_tlb[i];
+
+		if (e->valid && (e->vmid == ste->vmid) &&
+		    (iova >= e->iova) && (iova < (e->iova + e->size))) {
+			*pa = e->pa + (iova - e->iova);
+			return true;
+		}
+	}
+
+	if (!host_smmu_walk(ste, iova, &entry)) {
+		return false;
+	}
+
+	entry.valid = true;
+	entry.vmid = ste->vmid;
+	host_smmu_tlb[host_smmu_tlb_next] = entry;
+	host_smmu_tlb_next = (host_smmu_tlb_next + 1U) % HOST_SMMU_TLB_ENTRIES;
+
+	*pa = entry.pa + (iova - entry.iova);
+	return true;
+}
@@ -19,3 +19,18 @@ void host_buffer_arch_unmap(void *buf)
 {
 	(void)buf;
 }
+
+void *host_buffer_arch_map_window(unsigned long addr,
+				  unsigned long num_granules, bool ns)
+{
+	(void)num_granules;
+	(void)ns;
+
+	return (void *)addr;
+}
+
+void host_buffer_arch_unmap_window(void *buf, unsigned long num_granules)
+{
+	(void)buf;
+	(void)num_granules;
+}
@@ -6,25 +6,58 @@
 #include <arch.h>
 #include <debug.h>
 #include <gic.h>
+#include <granule.h>
+#include <host_defs.h>
+#include <host_tests.h>
 #include <host_utils.h>
+#include <import_sym.h>
 #include <platform_api.h>
 #include <rmm_el3_ifc.h>
+#include <sizes.h>
 #include <stdint.h>
+#include <sys/mman.h>
 #include <xlat_tables.h>
 
 #define RMM_EL3_IFC_ABI_VERSION		(RMM_EL3_IFC_SUPPORTED_VERSION)
 #define RMM_EL3_MAX_CPUS		(1U)
 
+IMPORT_SYM(uintptr_t, rmm_rw_end, RMM_RW_END);
+
+/*
+ * VA at which the RMM accesses the EL3 shared buffer, as set up by
+ * plat_cmn_setup(). The buffer is allocated at this address so that, as for
+ * the granules, its PA and VA are the same and the emulated EL3 services see
+ * what the RMM writes to it.
+ */
+#define HOST_SHARED_BUFFER_VA		(RMM_RW_END + SZ_4K)
+
 /*
  * Define and set the Boot Interface arguments.
  */
-static unsigned char el3_rmm_shared_buffer[PAGE_SIZE] __aligned(PAGE_SIZE);
+static unsigned char *el3_rmm_shared_buffer;
 
 /*
  * Create a basic boot manifest.
  */
-static struct rmm_core_manifest *boot_manifest =
-			(struct rmm_core_manifest *)el3_rmm_shared_buffer;
+static struct rmm_core_manifest *boot_manifest;
+static struct ns_dram_bank *host_dram_banks;
+
+static void setup_el3_rmm_shared_buffer(void)
+{
+	void *buf = mmap((void *)HOST_SHARED_BUFFER_VA, PAGE_SIZE,
+			 PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+			 -1, 0);
+
+	if (buf != (void *)HOST_SHARED_BUFFER_VA) {
+		ERROR("Cannot allocate the EL3 shared buffer at 0x%lx\n",
+		      HOST_SHARED_BUFFER_VA);
+		panic();
+	}
+
+	el3_rmm_shared_buffer = (unsigned char *)buf;
+	boot_manifest = (struct rmm_core_manifest *)el3_rmm_shared_buffer;
+}
 
 /*
  * Performs some initialization needed before RMM can be ran, such as
@@ -50,8 +83,24 @@ static void setup_sysreg_and_boot_manifest(void)
 	(void)host_util_set_default_sysreg_cb("sctlr_el2", 0UL);
 
 	/* Initialize the boot manifest */
-	boot_manifest->version = RMM_EL3_IFC_SUPPORTED_VERSION;
+	boot_manifest->version = RMM_EL3_MANIFEST_VERSION;
 	boot_manifest->plat_data = (uintptr_t)NULL;
+
+	/*
+	 * Describe the host granule buffer as a single DRAM bank. The bank
+	 * array is stored in the shared buffer, right after the manifest.
+	 */
+	host_dram_banks = (struct ns_dram_bank *)(boot_manifest + 1);
+	host_dram_banks[0].base = host_util_get_granule_base();
+	host_dram_banks[0].size = HOST_MEM_SIZE;
+
+	boot_manifest->plat_dram.num_banks = 1UL;
+	boot_manifest->plat_dram.banks = host_dram_banks;
+	boot_manifest->plat_dram.checksum = 0UL -
+				(boot_manifest->plat_dram.num_banks +
+				 (uintptr_t)host_dram_banks +
+				 host_dram_banks[0].base +
+				 host_dram_banks[0].size);
 }
 
 /*
@@ -66,9 +115,12 @@ void rmm_main(void);
 
 int main(int argc, char *argv[])
 {
+	int ret = 0;
+
 	(void)argc;
 	(void)argv;
 
+	setup_el3_rmm_shared_buffer();
 	setup_sysreg_and_boot_manifest();
 
 	VERBOSE("RMM: Beginning of Fake Host execution\n");
@@ -76,7 +128,7 @@ int main(int argc, char *argv[])
 	plat_setup(0UL,
 		   RMM_EL3_IFC_ABI_VERSION,
 		   RMM_EL3_MAX_CPUS,
-		   (uintptr_t)&el3_rmm_shared_buffer);
+		   (uintptr_t)el3_rmm_shared_buffer);
 
 	/*
 	 * Enable the MMU. This is needed as some initialization code
@@ -86,7 +138,13 @@ int main(int argc, char *argv[])
 
 	rmm_main();
 
+#ifdef RMM_HOST_TESTS
+	ret = host_run_tests();
+#endif
+
+	granule_lock_stats_dump();
+
 	VERBOSE("RMM: Fake Host execution completed\n");
 
-	return 0;
+	return ret;
 }
@@ -0,0 +1,224 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <granule.h>
+#include <host_tests.h>
+#include <host_utils.h>
+#include <realm.h>
+#include <sizes.h>
+#include <smc-handler.h>
+#include <smc-rmi.h>
+#include <string.h>
+#include <table.h>
+#include <utils_def.h>
+
+#define TEST_IPA_BITS		32U
+#define TEST_SL			1
+
+/*
+ * Granules used by the test, from the base of the host memory: the RD, the
+ * starting level RTT, the level 2 RTT, the two level 3 RTTs which translate
+ * [0, 2MB) and [2MB, 4MB), the list and the DATA granules.
+ */
+#define TEST_RD			0UL
+#define TEST_RTT_ROOT		1UL
+#define TEST_RTT_L2		2UL
+#define TEST_RTT_L3A		3UL
+#define TEST_RTT_L3B		4UL
+#define TEST_LIST		5UL
+#define TEST_DATA		6UL
+
+/*
+ * A full level 3 RTT of DATA granules from TEST_DATA maps [0, 2MB), and a
+ * single DATA granule, the next one, maps 2MB.
+ */
+#define TEST_NR_DATA		(S2TTES_PER_S2TT + 1UL)
+#define TEST_NR_GRANULES	(TEST_DATA + TEST_NR_DATA)
+
+/* Top of the IPA range torn down, translated by the level 3 RTTs */
+#define TEST_TOP		(2UL * SZ_2M)
+
+static unsigned long test_addr(unsigned long idx)
+{
+	return host_util_get_granule_base() + (idx * GRANULE_SIZE);
+}
+
+/* Creates a Realm in the NEW state with an empty starting level RTT */
+static bool test_realm_create(void)
+{
+	struct granule *g_rd, *g_rtt;
+	struct rd *rd;
+	unsigned long *s2tt;
+
+	g_rd = find_lock_granule(test_addr(TEST_RD), GRANULE_STATE_NS);
+	HOST_TEST_CHECK(g_rd != NULL);
+	g_rtt = find_lock_granule(test_addr(TEST_RTT_ROOT), GRANULE_STATE_NS);
+	HOST_TEST_CHECK(g_rtt != NULL);
+
+	rd = granule_map(g_rd, SLOT_RD);
+	(void)memset(rd, 0, sizeof(*rd));
+	set_rd_state(rd, REALM_STATE_NEW);
+	rd->s2_ctx.g_rtt = g_rtt;
+	rd->s2_ctx.ipa_bits = TEST_IPA_BITS;
+	rd->s2_ctx.s2_starting_level = TEST_SL;
+	rd->s2_ctx.num_root_rtts = 1U;
+	rd->walk_cache.g_tbl = NULL;
+	buffer_unmap(rd);
+
+	s2tt = granule_map(g_rtt, SLOT_RTT);
+	s2tt_init_unassigned(s2tt, RMI_EMPTY);
+	buffer_unmap(s2tt);
+
+	granule_unlock_transition(g_rd, GRANULE_STATE_RD);
+	granule_unlock_transition(g_rtt, GRANULE_STATE_RTT);
+	return true;
+}
+
+static bool test_delegate(unsigned long idx)
+{
+	struct granule *g = find_lock_granule(test_addr(idx),
+					      GRANULE_STATE_NS);
+
+	HOST_TEST_CHECK(g != NULL);
+	granule_unlock_transition(g, GRANULE_STATE_DELEGATED);
+	return true;
+}
+
+static bool test_undelegate(unsigned long idx, enum granule_state state)
+{
+	struct granule *g = find_lock_granule(test_addr(idx), state);
+
+	HOST_TEST_CHECK(g != NULL);
+	HOST_TEST_CHECK(granule_refcount_read(g) == 0UL);
+	granule_unlock_transition(g, GRANULE_STATE_NS);
+	return true;
+}
+
+static bool test_state(unsigned long idx, enum granule_state state)
+{
+	return granule_unlocked_state(find_granule(test_addr(idx))) == state;
+}
+
+/*
+ * Calls RMI_RTT_TEARDOWN on [@base, @top) and checks the returned resume
+ * address and the list written by the call, which must hold @nr_entries
+ * entries equal to @entries.
+ */
+static bool test_teardown(unsigned long base, unsigned long top,
+			  unsigned long resume,
+			  const struct rmi_released_granules *entries,
+			  unsigned long nr_entries)
+{
+	struct rmi_released_granules *list =
+		(struct rmi_released_granules *)test_addr(TEST_LIST);
+	struct smc_result res = { 0 };
+
+	(void)memset(list, 0xff, GRANULE_SIZE);
+
+	smc_rtt_teardown(test_addr(TEST_RD), base, top, test_addr(TEST_LIST),
+			 &res);
+
+	HOST_TEST_CHECK(res.x[0] == RMI_SUCCESS);
+	HOST_TEST_CHECK(res.x[1] == resume);
+	HOST_TEST_CHECK(res.x[2] == nr_entries);
+
+	for (unsigned long i = 0UL; i < nr_entries; i++) {
+		HOST_TEST_CHECK(list[i].addr == entries[i].addr);
+		HOST_TEST_CHECK(list[i].count == entries[i].count);
+
+		for (unsigned long g = 0UL; g < entries[i].count; g++) {
+			struct granule *g_rel = find_granule(entries[i].addr +
+							     (g * GRANULE_SIZE));
+
+			HOST_TEST_CHECK(granule_unlocked_state(g_rel) ==
+					GRANULE_STATE_DELEGATED);
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Tears down a Realm with a full level 3 RTT of DATA granules, which uses the
+ * whole budget of a call, followed by a level 3 RTT with a single DATA
+ * granule. Checks the resume address returned when the budget is exhausted,
+ * that the RTT emptied by the first call is destroyed by the next one and
+ * that the list reports exactly the released granules.
+ */
+bool host_test_rtt_teardown(void)
+{
+	struct smc_result res = { 0 };
+	const struct rmi_released_granules first[] = {
+		{ test_addr(TEST_DATA), S2TTES_PER_S2TT },
+	};
+	const struct rmi_released_granules second[] = {
+		{ test_addr(TEST_RTT_L3A), 1UL },
+		{ test_addr(TEST_DATA + S2TTES_PER_S2TT), 1UL },
+		{ test_addr(TEST_RTT_L3B), 1UL },
+	};
+	const struct rmi_released_granules third[] = {
+		{ test_addr(TEST_RTT_L2), 1UL },
+	};
+
+	HOST_TEST_CHECK(test_realm_create());
+
+	for (unsigned long i = TEST_RTT_L2; i < TEST_NR_GRANULES; i++) {
+		if (i != TEST_LIST) {
+			HOST_TEST_CHECK(test_delegate(i));
+		}
+	}
+
+	HOST_TEST_CHECK(smc_rtt_create(test_addr(TEST_RTT_L2),
+				       test_addr(TEST_RD), 0UL,
+				       2UL) == RMI_SUCCESS);
+	HOST_TEST_CHECK(smc_rtt_create(test_addr(TEST_RTT_L3A),
+				       test_addr(TEST_RD), 0UL,
+				       3UL) == RMI_SUCCESS);
+	HOST_TEST_CHECK(smc_rtt_create(test_addr(TEST_RTT_L3B),
+				       test_addr(TEST_RD), SZ_2M,
+				       3UL) == RMI_SUCCESS);
+
+	for (unsigned long i = 0UL; i < TEST_NR_DATA; i++) {
+		HOST_TEST_CHECK(smc_data_create_unknown(
+					test_addr(TEST_DATA + i),
+					test_addr(TEST_RD),
+					i * GRANULE_SIZE) == RMI_SUCCESS);
+	}
+
+	/* The list must be an NS granule, checked before any teardown */
+	smc_rtt_teardown(test_addr(TEST_RD), 0UL, TEST_TOP,
+			 test_addr(TEST_RD), &res);
+	HOST_TEST_CHECK(res.x[0] == RMI_ERROR_INPUT);
+	HOST_TEST_CHECK(test_state(TEST_DATA, GRANULE_STATE_DATA));
+
+	/*
+	 * The DATA granules of the first RTT use the whole budget. The RTT,
+	 * now empty, is left for the next call, which resumes from its base.
+	 */
+	HOST_TEST_CHECK(test_teardown(0UL, TEST_TOP, 0UL, first,
+				      ARRAY_SIZE(first)));
+	HOST_TEST_CHECK(test_state(TEST_RTT_L3A, GRANULE_STATE_RTT));
+	HOST_TEST_CHECK(test_state(TEST_DATA + S2TTES_PER_S2TT,
+				   GRANULE_STATE_DATA));
+
+	HOST_TEST_CHECK(test_teardown(0UL, TEST_TOP, TEST_TOP, second,
+				      ARRAY_SIZE(second)));
+	HOST_TEST_CHECK(test_state(TEST_RTT_L2, GRANULE_STATE_RTT));
+
+	/* The level 2 RTT is destroyed once the range covers it */
+	HOST_TEST_CHECK(test_teardown(0UL, SZ_1G, SZ_1G, third,
+				      ARRAY_SIZE(third)));
+
+	for (unsigned long i = TEST_RTT_L2; i < TEST_NR_GRANULES; i++) {
+		if (i != TEST_LIST) {
+			HOST_TEST_CHECK(test_undelegate(i,
+						GRANULE_STATE_DELEGATED));
+		}
+	}
+
+	HOST_TEST_CHECK(test_undelegate(TEST_RTT_ROOT, GRANULE_STATE_RTT));
+	HOST_TEST_CHECK(test_undelegate(TEST_RD, GRANULE_STATE_RD));
+	return true;
+}
@@ -0,0 +1,311 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <debug.h>
+#include <host_tests.h>
+#include <ripas.h>
+#include <sizes.h>
+#include <table.h>
+#include <time.h>
+#include <utils_def.h>
+
+/* Number of calls of each checker timed on a table */
+#define TEST_NR_ITERATIONS	10000U
+
+/* Base PA of the blocks, aligned to level 1 */
+#define TEST_BLOCK_PA		(0x80000000UL)
+
+enum test_entry {
+	TEST_UNASSIGNED_RAM = 0,
+	TEST_UNASSIGNED_EMPTY,
+	TEST_DESTROYED,
+	TEST_ASSIGNED,
+	TEST_VALID,
+	TEST_VALID_NS,
+	TEST_INVALID_NS,
+	TEST_NR_ENTRIES
+};
+
+/* Positions of the s2tte which differs in the mixed tables */
+static const unsigned int test_pos[] = { 0U, 1U, 7U, 8U, 300U, 511U };
+
+static unsigned long test_table[S2TTES_PER_S2TT] __aligned(GRANULE_SIZE);
+
+/*
+ * Reference implementation of the table checks, which calls the s2tte type
+ * checker on each s2tte. The checks of s2tt.c must give the same result.
+ */
+static bool ref_table_is_uniform_block(unsigned long *table,
+				       bool (*s2tte_is_x)(unsigned long),
+				       enum ripas *ripas_ptr)
+{
+	unsigned long s2tte = s2tte_read(&table[0]);
+	enum ripas ripas = RMI_EMPTY;
+
+	if (!s2tte_is_x(s2tte)) {
+		return false;
+	}
+
+	if (ripas_ptr != NULL) {
+		ripas = s2tte_get_ripas(s2tte);
+	}
+
+	for (unsigned int i = 1U; i < S2TTES_PER_S2TT; i++) {
+		s2tte = s2tte_read(&table[i]);
+
+		if (!s2tte_is_x(s2tte)) {
+			return false;
+		}
+
+		if ((ripas_ptr != NULL) &&
+		    (s2tte_get_ripas(s2tte) != ripas)) {
+			return false;
+		}
+	}
+
+	if (ripas_ptr != NULL) {
+		*ripas_ptr = ripas;
+	}
+
+	return true;
+}
+
+static bool ref_table_maps_block(unsigned long *table, long level,
+				 bool (*s2tte_is_x)(unsigned long, long))
+{
+	unsigned long s2tte = s2tte_read(&table[0]);
+	unsigned long map_size = s2tte_map_size((int)level);
+	unsigned long base_pa;
+
+	if (!s2tte_is_x(s2tte, level)) {
+		return false;
+	}
+
+	base_pa = s2tte_pa(s2tte, level);
+	if (!addr_is_level_aligned(base_pa, level - 1L)) {
+		return false;
+	}
+
+	for (unsigned int i = 1U; i < S2TTES_PER_S2TT; i++) {
+		s2tte = s2tte_read(&table[i]);
+
+		if (!s2tte_is_x(s2tte, level)) {
+			return false;
+		}
+
+		if (s2tte_pa(s2tte, level) != (base_pa + (i * map_size))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Checkers compared by the test. Each returns the result of the check of
+ * s2tt.c if @ref is false and of the reference implementation otherwise.
+ * The RIPAS returned by the unassigned check is folded in the result.
+ */
+static unsigned int check_unassigned(long level, bool ref)
+{
+	enum ripas ripas = RMI_EMPTY;
+	bool ret;
+
+	(void)level;
+
+	ret = ref ? ref_table_is_uniform_block(test_table,
+					       s2tte_is_unassigned, &ripas) :
+		    table_is_unassigned_block(test_table, &ripas);
+
+	return ret ? (1U + (unsigned int)ripas) : 0U;
+}
+
+static unsigned int check_unassigned_any_ripas(long level, bool ref)
+{
+	(void)level;
+
+	return ref ? (unsigned int)ref_table_is_uniform_block(test_table,
+					s2tte_is_unassigned, NULL) :
+		     (unsigned int)table_is_unassigned_block(test_table, NULL);
+}
+
+static unsigned int check_destroyed(long level, bool ref)
+{
+	(void)level;
+
+	return ref ? (unsigned int)ref_table_is_uniform_block(test_table,
+					s2tte_is_destroyed, NULL) :
+		     (unsigned int)table_is_destroyed_block(test_table);
+}
+
+static unsigned int check_assigned(long level, bool ref)
+{
+	return ref ? (unsigned int)ref_table_maps_block(test_table, level,
+							s2tte_is_assigned) :
+		     (unsigned int)table_maps_assigned_block(test_table, level);
+}
+
+static unsigned int check_valid(long level, bool ref)
+{
+	return ref ? (unsigned int)ref_table_maps_block(test_table, level,
+							s2tte_is_valid) :
+		     (unsigned int)table_maps_valid_block(test_table, level);
+}
+
+static unsigned int check_valid_ns(long level, bool ref)
+{
+	return ref ? (unsigned int)ref_table_maps_block(test_table, level,
+							s2tte_is_valid_ns) :
+		     (unsigned int)table_maps_valid_ns_block(test_table, level);
+}
+
+struct test_checker {
+	const char *name;
+	unsigned int (*check)(long level, bool ref);
+	/* Type of the s2ttes of the table on which the check is timed */
+	enum test_entry entry;
+};
+
+static const struct test_checker test_checkers[] = {
+	{ "unassigned", check_unassigned, TEST_UNASSIGNED_RAM },
+	{ "unassigned_any_ripas", check_unassigned_any_ripas,
+	  TEST_UNASSIGNED_EMPTY },
+	{ "destroyed", check_destroyed, TEST_DESTROYED },
+	{ "assigned", check_assigned, TEST_ASSIGNED },
+	{ "valid", check_valid, TEST_VALID },
+	{ "valid_ns", check_valid_ns, TEST_VALID_NS },
+};
+
+static unsigned long test_s2tte(enum test_entry entry, unsigned long pa,
+				long level)
+{
+	switch (entry) {
+	case TEST_UNASSIGNED_RAM:
+		return s2tte_create_unassigned(RMI_RAM);
+	case TEST_UNASSIGNED_EMPTY:
+		return s2tte_create_unassigned(RMI_EMPTY);
+	case TEST_DESTROYED:
+		return s2tte_create_destroyed();
+	case TEST_ASSIGNED:
+		return s2tte_create_assigned_empty(pa, level);
+	case TEST_VALID:
+		return s2tte_create_valid(pa, level);
+	case TEST_VALID_NS:
+		return s2tte_create_valid_ns(pa, level);
+	default:
+		return s2tte_create_invalid_ns();
+	}
+}
+
+/* Fills the table with contiguous s2ttes of type @entry from @pa */
+static void test_fill(enum test_entry entry, unsigned long pa, long level)
+{
+	unsigned long map_size = s2tte_map_size((int)level);
+
+	for (unsigned int i = 0U; i < S2TTES_PER_S2TT; i++) {
+		test_table[i] = test_s2tte(entry, pa + (i * map_size), level);
+	}
+}
+
+/* Returns true if all the checkers give the same result on the table */
+static bool test_compare(long level)
+{
+	for (unsigned int c = 0U; c < ARRAY_SIZE(test_checkers); c++) {
+		unsigned int ret = test_checkers[c].check(level, false);
+
+		if (ret != test_checkers[c].check(level, true)) {
+			ERROR("%s check differs at level %ld\n",
+			      test_checkers[c].name, level);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static unsigned long test_time_ns(const struct test_checker *checker,
+				  long level, bool ref)
+{
+	struct timespec start, end;
+	volatile unsigned int sink = 0U;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned int i = 0U; i < TEST_NR_ITERATIONS; i++) {
+		sink += checker->check(level, ref);
+	}
+	(void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+	(void)sink;
+	return (((unsigned long)(end.tv_sec - start.tv_sec) * 1000000000UL) +
+		(unsigned long)end.tv_nsec - (unsigned long)start.tv_nsec) /
+		TEST_NR_ITERATIONS;
+}
+
+/*
+ * Checks that the table checks used by RTT_FOLD and RTT_DESTROY give the
+ * same result as the reference implementation on uniform tables, on tables
+ * which map a non-contiguous or misaligned block and on tables with one
+ * s2tte of another type, at both block levels.
+ *
+ * The checks are then timed against the reference implementation on
+ * uniform tables of the type they look for.
+ */
+bool host_test_s2tt_table_scan(void)
+{
+	for (long level = RTT_MIN_BLOCK_LEVEL; level <= RTT_PAGE_LEVEL;
+	     level++) {
+		unsigned long map_size = s2tte_map_size((int)level);
+
+		for (unsigned int e = 0U; e < (unsigned int)TEST_NR_ENTRIES;
+		     e++) {
+			enum test_entry entry = (enum test_entry)e;
+
+			/* Uniform table */
+			test_fill(entry, TEST_BLOCK_PA, level);
+			HOST_TEST_CHECK(test_compare(level));
+
+			/* Block not aligned to @level - 1 */
+			test_fill(entry, TEST_BLOCK_PA + map_size, level);
+			HOST_TEST_CHECK(test_compare(level));
+
+			for (unsigned int p = 0U; p < ARRAY_SIZE(test_pos);
+			     p++) {
+				unsigned int i = test_pos[p];
+				unsigned long pa = TEST_BLOCK_PA +
+						   (i * map_size);
+
+				/* Non-contiguous block */
+				test_fill(entry, TEST_BLOCK_PA, level);
+				test_table[i] = test_s2tte(entry,
+						pa + (S2TTES_PER_S2TT * map_size),
+						level);
+				HOST_TEST_CHECK(test_compare(level));
+
+				/* One s2tte of each other type */
+				for (unsigned int o = 0U;
+				     o < (unsigned int)TEST_NR_ENTRIES; o++) {
+					test_fill(entry, TEST_BLOCK_PA, level);
+					test_table[i] = test_s2tte(
+						(enum test_entry)o, pa, level);
+					HOST_TEST_CHECK(test_compare(level));
+				}
+			}
+		}
+
+		for (unsigned int c = 0U; c < ARRAY_SIZE(test_checkers); c++) {
+			const struct test_checker *checker = &test_checkers[c];
+			unsigned long scan_ns, ref_ns;
+
+			test_fill(checker->entry, TEST_BLOCK_PA, level);
+
+			scan_ns = test_time_ns(checker, level, false);
+			ref_ns = test_time_ns(checker, level, true);
+			NOTICE("s2tt %s, level %ld: %lu ns (reference %lu ns)\n",
+			       checker->name, level, scan_ns, ref_ns);
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,109 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <granule.h>
+#include <host_smmu.h>
+#include <host_tests.h>
+#include <host_utils.h>
+#include <realm.h>
+#include <sizes.h>
+#include <smc-rmi.h>
+#include <smmu.h>
+#include <utils_def.h>
+
+#define TEST_SID		0x10U
+#define TEST_VMID		1U
+
+/*
+ * The range is mapped with a 2MB block followed by TEST_NR_PAGES pages, all
+ * translated by the same level 2 table.
+ */
+#define TEST_IOVA		0x80000000UL
+#define TEST_NR_PAGES		4UL
+#define TEST_MAP_SIZE		(SZ_2M + (TEST_NR_PAGES * GRANULE_SIZE))
+
+/* Root table and the level 1, level 2 and level 3 tables */
+#define TEST_NR_TABLES		4UL
+
+/*
+ * Builds the SMMU stage 2 tables of a stream, maps a range with both a block
+ * and pages and checks the translation of each page by the SMMU model. The
+ * range is then unmapped: as the entries are cleared, any translation left
+ * by the model comes from a TLB entry which was not invalidated.
+ *
+ * The first granules of the host memory are used as RD and tables, and the
+ * range is mapped to the first 2MB aligned PA after them.
+ */
+bool host_test_smmu_map_unmap(void)
+{
+	unsigned long base = host_util_get_granule_base();
+	unsigned long data_pa = round_up(base + ((TEST_NR_TABLES + 1UL) *
+						 GRANULE_SIZE), SZ_2M);
+	struct s2_walk_run run = {
+		.ipa = TEST_IOVA,
+		.pa = data_pa,
+		.size = TEST_MAP_SIZE
+	};
+	struct granule *g_rd, *g_tbl[TEST_NR_TABLES];
+	unsigned long mapped, next, pa;
+
+	/* The SMMU library only uses the RD to identify the owner */
+	g_rd = find_lock_granule(base, GRANULE_STATE_NS);
+	HOST_TEST_CHECK(g_rd != NULL);
+	granule_set_state(g_rd, GRANULE_STATE_RD);
+
+	for (unsigned long i = 0UL; i < TEST_NR_TABLES; i++) {
+		g_tbl[i] = find_lock_granule(base + ((i + 1UL) * GRANULE_SIZE),
+					     GRANULE_STATE_NS);
+		HOST_TEST_CHECK(g_tbl[i] != NULL);
+		granule_set_state(g_tbl[i], GRANULE_STATE_DELEGATED);
+	}
+
+	HOST_TEST_CHECK(smmu_stream_create(TEST_SID, g_rd, TEST_VMID,
+					   g_tbl[0]) == RMI_SUCCESS);
+	granule_unlock(g_tbl[0]);
+
+	for (unsigned long i = 1UL; i < TEST_NR_TABLES; i++) {
+		HOST_TEST_CHECK(smmu_stream_table_add(TEST_SID, g_rd,
+						      g_tbl[i]) == RMI_SUCCESS);
+		granule_unlock(g_tbl[i]);
+	}
+
+	HOST_TEST_CHECK(smmu_stream_map(TEST_SID, g_rd, &run, 1U,
+					&mapped) == RMI_SUCCESS);
+	HOST_TEST_CHECK(mapped == TEST_MAP_SIZE);
+
+	for (unsigned long off = 0UL; off < TEST_MAP_SIZE;
+	     off += GRANULE_SIZE) {
+		HOST_TEST_CHECK(host_smmu_translate(TEST_SID, TEST_IOVA + off,
+						    &pa));
+		HOST_TEST_CHECK(pa == (data_pa + off));
+	}
+	HOST_TEST_CHECK(!host_smmu_translate(TEST_SID,
+					     TEST_IOVA + TEST_MAP_SIZE, &pa));
+
+	HOST_TEST_CHECK(smmu_stream_unmap(TEST_SID, g_rd, TEST_IOVA,
+					  TEST_IOVA + TEST_MAP_SIZE,
+					  &next) == RMI_SUCCESS);
+	HOST_TEST_CHECK(next == (TEST_IOVA + TEST_MAP_SIZE));
+
+	for (unsigned long off = 0UL; off < TEST_MAP_SIZE;
+	     off += GRANULE_SIZE) {
+		HOST_TEST_CHECK(!host_smmu_translate(TEST_SID,
+						     TEST_IOVA + off, &pa));
+	}
+
+	HOST_TEST_CHECK(smmu_stream_destroy(TEST_SID, g_rd) == RMI_SUCCESS);
+
+	for (unsigned long i = 0UL; i < TEST_NR_TABLES; i++) {
+		g_tbl[i] = find_lock_granule(base + ((i + 1UL) * GRANULE_SIZE),
+					     GRANULE_STATE_DELEGATED);
+		HOST_TEST_CHECK(g_tbl[i] != NULL);
+		granule_unlock_transition(g_tbl[i], GRANULE_STATE_NS);
+	}
+
+	granule_unlock_transition(g_rd, GRANULE_STATE_NS);
+	return true;
+}
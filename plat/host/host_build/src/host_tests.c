@@ -0,0 +1,39 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <debug.h>
+#include <host_tests.h>
+#include <utils_def.h>
+
+struct host_test {
+	const char *name;
+	bool (*run)(void);
+};
+
+static const struct host_test host_tests[] = {
+	{ "smmu_map_unmap", host_test_smmu_map_unmap },
+	{ "s2tt_table_scan", host_test_s2tt_table_scan },
+	{ "rtt_teardown", host_test_rtt_teardown },
+};
+
+int host_run_tests(void)
+{
+	unsigned int failed = 0U;
+
+	for (unsigned int i = 0U; i < ARRAY_SIZE(host_tests); i++) {
+		bool passed = host_tests[i].run();
+
+		NOTICE("[%s] %s\n", passed ? "PASS" : "FAIL",
+		       host_tests[i].name);
+		if (!passed) {
+			failed++;
+		}
+	}
+
+	NOTICE("Host tests: %u passed, %u failed\n",
+	       (unsigned int)ARRAY_SIZE(host_tests) - failed, failed);
+
+	return (failed == 0U) ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#ifndef HOST_TESTS_H
+#define HOST_TESTS_H
+
+#include <debug.h>
+#include <stdbool.h>
+
+/*
+ * Fails the calling test, which must return bool, if @cond does not hold.
+ */
+#define HOST_TEST_CHECK(cond)						\
+	do {								\
+		if (!(cond)) {						\
+			ERROR("%s:%d: check failed: %s\n",		\
+			      __FILE__, __LINE__, #cond);		\
+			return false;					\
+		}							\
+	} while (false)
+
+/*
+ * Run the fake_host tests. They are run once the RMM is initialized, from
+ * the boot CPU.
+ *
+ * Returns 0 if all the tests pass, 1 otherwise.
+ */
+int host_run_tests(void);
+
+/* Tests, which return true if they pass */
+bool host_test_smmu_map_unmap(void);
+bool host_test_s2tt_table_scan(void);
+bool host_test_rtt_teardown(void);
+
+#endif /* HOST_TESTS_H */
@@ -8,6 +8,7 @@
 #include <arch_helpers.h>
 #include <attestation_token.h>
 #include <buffer.h>
+#include <dev.h>
 #include <esr.h>
 #include <exit.h>
 #include <fpu_helpers.h>
@@ -104,12 +105,10 @@ static bool ipa_is_empty(unsigned long ipa, struct rec *rec)
 	}
 	granule_lock(rec->realm_info.g_rtt, GRANULE_STATE_RTT);
 
-	rtt_walk_lock_unlock(rec->realm_info.g_rtt,
-			     rec->realm_info.s2_starting_level,
-			     rec->realm_info.ipa_bits,
-			     ipa, RTT_PAGE_LEVEL, &wi);
-
-	ll_table = granule_map(wi.g_llt, SLOT_RTT);
+	ll_table = rtt_walk_lock_unlock_map(rec->realm_info.g_rtt,
+					    rec->realm_info.s2_starting_level,
+					    rec->realm_info.ipa_bits,
+					    ipa, RTT_PAGE_LEVEL, &wi);
 	s2tte = s2tte_read(&ll_table[wi.index]);
 
 	if (s2tte_is_destroyed(s2tte)) {
@@ -535,10 +534,18 @@ static bool handle_realm_rsi(struct rec *rec, struct rmi_rec_exit *rec_exit)
 		WARN("handle_rsi_dev_mem \n");
 		WARN("IPA %lx\n",rec->regs[1]);
 		res = handle_rsi_dev_mem(rec, rec_exit);
-		WARN("PA %lx\n",rec->regs[1]);
-		
+
+		if (res.walk_result.abort) {
+			emulate_stage2_data_abort(rec, rec_exit,
+						  res.walk_result.rtt_level);
+			/* Exit to Host, the Realm resumes from the faulting IPA */
+			ret_to_rec = false;
+			break;
+		}
+
 		ret_to_rec = true;
 		rec->regs[0] = res.smc_result;
+		rec->regs[1] = res.next_ipa;
 		break;
 		// Do we need it ???
 		// Probably yes, without it we get "invalid RSI function_id = 0" in the RMM log
@@ -556,19 +563,34 @@ static bool handle_realm_rsi(struct rec *rec, struct rmi_rec_exit *rec_exit)
 		break;
 	}
 	case _SMC_REQUEST_DEVICE_OWNERSHIP: {
-		struct rsi_delegate_dev_mem_result res;
-		WARN("handle_rsi_dev_mem \n");
+		unsigned int vmid;
 
-		// TODO: get the vmid, rec_idx is NOT the vmid.
-		res.smc_result = monitor_call(SMC_REQUEST_DEVICE_OWNERSHIP, rec->regs[1], rec->rec_idx, 0, 0, 0, 0);
-		
-		ret_to_rec = true;
-		rec->regs[0] = res.smc_result;
+		/* reg[1] : StreamID of the device */
+		if ((rec->regs[1] > UINT32_MAX) ||
+		    !dev_lookup((unsigned int)rec->regs[1],
+				rec->realm_info.g_rd, &vmid, NULL)) {
+			rec->regs[0] = RSI_ERROR_INPUT;
+			break;
+		}
 
+		rec->regs[0] = monitor_call(SMC_REQUEST_DEVICE_OWNERSHIP,
+					    rec->regs[1], vmid, 0, 0, 0, 0);
 		break;
 	}
 	case _SMC_TRIGGER_TESTENGINE: {
+		bool attached = false;
+
 		WARN("handle_trigger_testengine iova_src: 0x%lx iova_dst: 0x%lx sid: %lx \n",rec->regs[1],rec->regs[2],rec->regs[3]);
+
+		/* Only a device attached to the Realm can be triggered */
+		if ((rec->regs[3] > UINT32_MAX) ||
+		    !dev_lookup((unsigned int)rec->regs[3],
+				rec->realm_info.g_rd, NULL, &attached) ||
+		    !attached) {
+			rec->regs[0] = RSI_ERROR_INPUT;
+			break;
+		}
+
 		ret_to_rec = false;
 
 		rec_exit->exit_reason = RMI_EXIT_TRIGGER_TESTENGINE;
@@ -30,12 +30,12 @@ COMPILER_ASSERT(ARRAY_LEN(status_handler) == RMI_ERROR_COUNT);
 
 /*
  * At this level (in handle_ns_smc) we distinguish the RMI calls only on:
- * - The number of input arguments [0..4], and whether
+ * - The number of input arguments [0..6], and whether
  * - The function returns up to three output values in addition
  *   to the return status code.
  * Hence, the naming syntax is:
- * - `*_[0..4]` when no output values are returned, and
- * - `*_[0..4]_o` when the function returns some output values.
+ * - `*_[0..5]` when no output values are returned, and
+ * - `*_[0..6]_o` when the function returns some output values.
  */
 
 typedef unsigned long (*handler_0)(void);
@@ -49,8 +49,17 @@ typedef unsigned long (*handler_5)(unsigned long arg0, unsigned long arg1,
 				   unsigned long arg2, unsigned long arg3,
 				   unsigned long arg4);
 typedef void (*handler_1_o)(unsigned long arg0, struct smc_result *ret);
+typedef void (*handler_2_o)(unsigned long arg0, unsigned long arg1,
+			    struct smc_result *ret);
 typedef void (*handler_3_o)(unsigned long arg0, unsigned long arg1,
 			    unsigned long arg2, struct smc_result *ret);
+typedef void (*handler_4_o)(unsigned long arg0, unsigned long arg1,
+			    unsigned long arg2, unsigned long arg3,
+			    struct smc_result *ret);
+typedef void (*handler_6_o)(unsigned long arg0, unsigned long arg1,
+			    unsigned long arg2, unsigned long arg3,
+			    unsigned long arg4, unsigned long arg5,
+			    struct smc_result *ret);
 
 enum rmi_type {
 	rmi_type_0,
@@ -60,7 +69,10 @@ enum rmi_type {
 	rmi_type_4,
 	rmi_type_5,
 	rmi_type_1_o,
-	rmi_type_3_o
+	rmi_type_2_o,
+	rmi_type_3_o,
+	rmi_type_4_o,
+	rmi_type_6_o
 };
 
 struct smc_handler {
@@ -74,7 +86,10 @@ struct smc_handler {
 		handler_4	f4;
 		handler_5	f5;
 		handler_1_o	f1_o;
+		handler_2_o	f2_o;
 		handler_3_o	f3_o;
+		handler_4_o	f4_o;
+		handler_6_o	f6_o;
 		void		*fn_dummy;
 	};
 	bool		log_exec;	/* print handler execution */
@@ -116,10 +131,22 @@ struct smc_handler {
 	.fn_name = #_id, \
 	.type = rmi_type_1_o, .f1_o = _fn, .log_exec = _exec, .log_error = _error, \
 	.out_values = _values }
+#define HANDLER_2_O(_id, _fn, _exec, _error, _values)[SMC_RMI_HANDLER_ID(_id)] = { \
+	.fn_name = #_id, \
+	.type = rmi_type_2_o, .f2_o = _fn, .log_exec = _exec, .log_error = _error, \
+	.out_values = _values }
 #define HANDLER_3_O(_id, _fn, _exec, _error, _values)[SMC_RMI_HANDLER_ID(_id)] = { \
 	.fn_name = #_id, \
 	.type = rmi_type_3_o, .f3_o = _fn, .log_exec = _exec, .log_error = _error, \
 	.out_values = _values }
+#define HANDLER_4_O(_id, _fn, _exec, _error, _values)[SMC_RMI_HANDLER_ID(_id)] = { \
+	.fn_name = #_id, \
+	.type = rmi_type_4_o, .f4_o = _fn, .log_exec = _exec, .log_error = _error, \
+	.out_values = _values }
+#define HANDLER_6_O(_id, _fn, _exec, _error, _values)[SMC_RMI_HANDLER_ID(_id)] = { \
+	.fn_name = #_id, \
+	.type = rmi_type_6_o, .f6_o = _fn, .log_exec = _exec, .log_error = _error, \
+	.out_values = _values }
 
 /*
  * The 3rd value enables the execution log.
@@ -148,7 +175,22 @@ static const struct smc_handler smc_handlers[] = {
 	HANDLER_2(SMC_RMM_PSCI_COMPLETE,	 smc_psci_complete,		true,  true),
 	HANDLER_1_O(SMC_RMM_REC_AUX_COUNT,	 smc_rec_aux_count,		true,  true, 1U),
 	HANDLER_3(SMC_RMM_RTT_INIT_RIPAS,	 smc_rtt_init_ripas,		false, true),
-	HANDLER_5(SMC_RMM_RTT_SET_RIPAS,	 smc_rtt_set_ripas,		false, true)
+	HANDLER_5(SMC_RMM_RTT_SET_RIPAS,	 smc_rtt_set_ripas,		false, true),
+	HANDLER_2_O(SMC_RMM_GRANULE_DELEGATE_RANGE, smc_granule_delegate_range,	false, true, 1U),
+	HANDLER_2_O(SMC_RMM_GRANULE_UNDELEGATE_RANGE, smc_granule_undelegate_range, false, true, 1U),
+	HANDLER_2(SMC_RMM_GRANULE_LOCK_STATS,	 smc_granule_lock_stats,	false, true),
+	HANDLER_6_O(SMC_RMM_DATA_CREATE_RANGE,	 smc_data_create_range,		false, true, 1U),
+	HANDLER_3_O(SMC_RMM_RTT_INIT_RIPAS_RANGE, smc_rtt_init_ripas_range,	false, true, 1U),
+	HANDLER_1_O(SMC_RMM_RTT_FOLD_QUERY,	 smc_rtt_fold_query,		false, true, 4U),
+	HANDLER_4_O(SMC_RMM_RTT_TEARDOWN,	 smc_rtt_teardown,		false, true, 2U),
+	HANDLER_4_O(SMC_RMM_RTT_READ_ENTRIES,	 smc_rtt_read_entries,		false, true, 3U),
+	HANDLER_3(SMC_RMM_SMMU_STREAM_CREATE,	 smc_smmu_stream_create,	false, true),
+	HANDLER_2(SMC_RMM_SMMU_STREAM_DESTROY,	 smc_smmu_stream_destroy,	false, true),
+	HANDLER_3(SMC_RMM_SMMU_TABLE_ADD,	 smc_smmu_table_add,		false, true),
+	HANDLER_4_O(SMC_RMM_SMMU_MAP,		 smc_smmu_map,			false, true, 1U),
+	HANDLER_4_O(SMC_RMM_SMMU_UNMAP,		 smc_smmu_unmap,		false, true, 1U),
+	HANDLER_3(SMC_RMM_DEV_CREATE,		 smc_dev_create,		false, true),
+	HANDLER_2(SMC_RMM_DEV_DESTROY,		 smc_dev_destroy,		false, true)
 };
 
 COMPILER_ASSERT(ARRAY_LEN(smc_handlers) == SMC64_NUM_FIDS_IN_RANGE(RMI));
@@ -266,9 +308,18 @@ void handle_ns_smc(unsigned long function_id,
 	case rmi_type_1_o:
 		handler->f1_o(arg0, ret);
 		break;
+	case rmi_type_2_o:
+		handler->f2_o(arg0, arg1, ret);
+		break;
 	case rmi_type_3_o:
 		handler->f3_o(arg0, arg1, arg2, ret);
 		break;
+	case rmi_type_4_o:
+		handler->f4_o(arg0, arg1, arg2, arg3, ret);
+		break;
+	case rmi_type_6_o:
+		handler->f6_o(arg0, arg1, arg2, arg3, arg4, arg5, ret);
+		break;
 	default:
 		assert(false);
 	}
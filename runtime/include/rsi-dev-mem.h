@@ -12,6 +12,12 @@ struct rsi_delegate_dev_mem_result {
 	 * @smc_result contains X0 value to be returned to the Realm.
 	 */
 	unsigned long smc_result;
+
+	/*
+	 * IPA of the first granule which has not been processed yet,
+	 * returned to the Realm in X1.
+	 */
+	unsigned long next_ipa;
 };
 
 struct rsi_delegate_dev_mem_result handle_rsi_dev_mem(struct rec *rec, struct rmi_rec_exit *rec_exit);
@@ -19,6 +19,14 @@ unsigned long smc_data_create(unsigned long data_addr,
 			      unsigned long src_addr,
 			      unsigned long flags);
 
+void smc_data_create_range(unsigned long data_addr,
+			   unsigned long rd_addr,
+			   unsigned long map_addr,
+			   unsigned long src_addr,
+			   unsigned long flags,
+			   unsigned long count,
+			   struct smc_result *ret_struct);
+
 unsigned long smc_data_create_unknown(unsigned long data_addr,
 				      unsigned long rd_addr,
 				      unsigned long map_addr);
@@ -30,6 +38,17 @@ unsigned long smc_granule_delegate(unsigned long addr);
 
 unsigned long smc_granule_undelegate(unsigned long addr);
 
+void smc_granule_delegate_range(unsigned long base,
+				unsigned long count,
+				struct smc_result *ret_struct);
+
+void smc_granule_undelegate_range(unsigned long base,
+				  unsigned long count,
+				  struct smc_result *ret_struct);
+
+unsigned long smc_granule_lock_stats(unsigned long ns_addr,
+				     unsigned long cpu_id);
+
 unsigned long smc_realm_activate(unsigned long rd_addr);
 
 unsigned long smc_realm_create(unsigned long rd_addr,
@@ -78,6 +97,42 @@ void smc_rtt_read_entry(unsigned long rd_addr,
 			unsigned long ulevel,
 			struct smc_result *ret_struct);
 
+void smc_rtt_read_entries(unsigned long rd_addr,
+			  unsigned long base,
+			  unsigned long top,
+			  unsigned long list_addr,
+			  struct smc_result *ret_struct);
+
+unsigned long smc_smmu_stream_create(unsigned long rd_addr,
+				     unsigned long sid,
+				     unsigned long root_addr);
+
+unsigned long smc_smmu_stream_destroy(unsigned long rd_addr,
+				      unsigned long sid);
+
+unsigned long smc_smmu_table_add(unsigned long rd_addr,
+				 unsigned long sid,
+				 unsigned long table_addr);
+
+void smc_smmu_map(unsigned long rd_addr,
+		  unsigned long sid,
+		  unsigned long base,
+		  unsigned long top,
+		  struct smc_result *ret_struct);
+
+void smc_smmu_unmap(unsigned long rd_addr,
+		    unsigned long sid,
+		    unsigned long base,
+		    unsigned long top,
+		    struct smc_result *ret_struct);
+
+unsigned long smc_dev_create(unsigned long rd_addr,
+			     unsigned long dev_addr,
+			     unsigned long sid);
+
+unsigned long smc_dev_destroy(unsigned long rd_addr,
+			      unsigned long sid);
+
 unsigned long smc_psci_complete(unsigned long calling_rec_addr,
 				unsigned long target_rec_addr);
 
@@ -85,6 +140,20 @@ unsigned long smc_rtt_init_ripas(unsigned long rd_addr,
 				 unsigned long map_addr,
 				 unsigned long ulevel);
 
+void smc_rtt_init_ripas_range(unsigned long rd_addr,
+			      unsigned long base,
+			      unsigned long top,
+			      struct smc_result *ret_struct);
+
+void smc_rtt_fold_query(unsigned long rd_addr,
+			struct smc_result *ret_struct);
+
+void smc_rtt_teardown(unsigned long rd_addr,
+		      unsigned long base,
+		      unsigned long top,
+		      unsigned long list_addr,
+		      struct smc_result *ret_struct);
+
 unsigned long smc_rtt_set_ripas(unsigned long rd_addr,
 				unsigned long rec_addr,
 				unsigned long map_addr,
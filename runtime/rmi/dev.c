@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <buffer.h>
+#include <dev.h>
+#include <granule.h>
+#include <realm.h>
+#include <smc-handler.h>
+#include <smc-rmi.h>
+#include <smmu.h>
+#include <stdint.h>
+#include <benchmark.h>
+
+unsigned long smc_dev_create(unsigned long rd_addr,
+			     unsigned long dev_addr,
+			     unsigned long sid)
+{
+	smc_dev_create_cca_marker();
+	struct granule *g_rd, *g_dev;
+	struct rd *rd;
+	unsigned long ret;
+
+	if (sid > UINT32_MAX) {
+		return RMI_ERROR_INPUT;
+	}
+
+	if (!find_lock_two_granules(rd_addr,
+				    GRANULE_STATE_RD,
+				    &g_rd,
+				    dev_addr,
+				    GRANULE_STATE_DELEGATED,
+				    &g_dev)) {
+		return RMI_ERROR_INPUT;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	ret = dev_create((unsigned int)sid, g_rd, rd, g_dev);
+	if (ret == RMI_SUCCESS) {
+		__granule_get(g_rd);
+	}
+
+	buffer_unmap(rd);
+	granule_unlock(g_dev);
+	granule_unlock(g_rd);
+
+	return ret;
+}
+
+unsigned long smc_dev_destroy(unsigned long rd_addr,
+			      unsigned long sid)
+{
+	smc_dev_destroy_cca_marker();
+	struct granule *g_rd;
+	struct rd *rd;
+	unsigned long ret;
+
+	if (sid > UINT32_MAX) {
+		return RMI_ERROR_INPUT;
+	}
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		return RMI_ERROR_INPUT;
+	}
+
+	/*
+	 * The stage 2 tables of the device must be destroyed first. No stream
+	 * can be created for it while the RD is locked.
+	 */
+	if (smmu_stream_rd((unsigned int)sid) == g_rd) {
+		granule_unlock(g_rd);
+		return RMI_ERROR_IN_USE;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	ret = dev_destroy((unsigned int)sid, g_rd, rd);
+	if (ret == RMI_SUCCESS) {
+		__granule_put(g_rd);
+	}
+
+	buffer_unmap(rd);
+	granule_unlock(g_rd);
+
+	return ret;
+}
@@ -22,24 +22,26 @@ unsigned long smc_granule_delegate(unsigned long addr)
 
 	granule_set_state(g, GRANULE_STATE_DELEGATED);
 	asc_mark_secure(addr);
-	granule_memzero(g, SLOT_DELEGATED);
 
-	granule_unlock(g);
-	return RMI_SUCCESS;
-}
+	/* Zeroing is deferred until the granule is first used by a realm */
+	granule_set_needs_scrub(g);
 
-unsigned long smc_add_page_to_smmu_tables(unsigned long phys_addr, unsigned long iova, unsigned int sid)
-{
-	asc_add_translation_table(phys_addr, iova, sid);
+	granule_unlock(g);
 	return RMI_SUCCESS;
 }
 
-unsigned long smc_granule_delegate_dev(unsigned long addr, unsigned long delegate_flag, unsigned long iova)
+/*
+ * Delegate or undelegate the @count device memory granules described by
+ * @entries with a single call to EL3.
+ *
+ * Returns the number of entries which were successfully transitioned.
+ */
+unsigned int smc_granule_delegate_dev(struct asc_batch_entry *entries,
+				      unsigned int count,
+				      unsigned long delegate_flag)
 {
-	asc_mark_secure_dev(addr, delegate_flag, iova);
-	//TODO[Supraja] : remove this later if we definitely don't need to maintain state
-	// g->nsp = true; We no longer need this
-	return RMI_SUCCESS;
+	return asc_mark_batch(ASC_BATCH_MARK_SECURE_DEV, delegate_flag,
+			      entries, count);
 }
 
 unsigned long smc_attach_dev(unsigned long addr)
@@ -58,8 +60,215 @@ unsigned long smc_granule_undelegate(unsigned long addr)
 	}
 
 	asc_mark_nonsecure(addr);
+	granule_clear_needs_scrub(g);
 	granule_set_state(g, GRANULE_STATE_NS);
 
 	granule_unlock(g);
 	return RMI_SUCCESS;
 }
+
+/*
+ * Maximum number of granules transitioned by a single
+ * RMI_GRANULE_DELEGATE_RANGE or RMI_GRANULE_UNDELEGATE_RANGE call. This bounds
+ * the time spent in the RMM before returning to the host, which resumes the
+ * operation from the returned address.
+ */
+#define GRANULE_RANGE_MAX_GRANULES	(512UL)
+
+/*
+ * Number of granules which are locked and transitioned together.
+ */
+#define GRANULE_RANGE_BATCH		(32UL)
+COMPILER_ASSERT(GRANULE_RANGE_BATCH <= ASC_BATCH_MAX_ENTRIES);
+
+/*
+ * Lock up to @count consecutive granules starting at @addr, which are expected
+ * to be in @expected_state. The granules are locked in order of increasing
+ * physical address and locking stops at the first granule which cannot be
+ * locked, as required by the locking rules for `external` granule states.
+ *
+ * Returns the number of granules locked, which are stored in @g_run.
+ */
+static unsigned long find_lock_granule_run(unsigned long addr,
+					   unsigned long count,
+					   enum granule_state expected_state,
+					   struct granule *g_run[])
+{
+	unsigned long i;
+
+	for (i = 0UL; i < count; i++) {
+		g_run[i] = find_lock_granule(addr + (i * GRANULE_SIZE),
+					     expected_state);
+		if (g_run[i] == NULL) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+/*
+ * Validate the arguments of a granule range command and return the number of
+ * granules to be processed by this call, or 0 if the arguments are invalid.
+ */
+static unsigned long granule_range_count(unsigned long base,
+					 unsigned long count)
+{
+	if (!GRANULE_ALIGNED(base) || (count == 0UL)) {
+		return 0UL;
+	}
+
+	/* Check that the range does not wrap around the address space */
+	if ((count - 1UL) > ((~0UL - base) >> GRANULE_SHIFT)) {
+		return 0UL;
+	}
+
+	return (count > GRANULE_RANGE_MAX_GRANULES) ?
+		GRANULE_RANGE_MAX_GRANULES : count;
+}
+
+static unsigned long delegate_run(unsigned long addr, unsigned long count)
+{
+	struct granule *g_run[GRANULE_RANGE_BATCH];
+	struct asc_batch_entry entries[GRANULE_RANGE_BATCH];
+	unsigned long locked, done, i;
+
+	locked = find_lock_granule_run(addr, count, GRANULE_STATE_NS, g_run);
+
+	for (i = 0UL; i < locked; i++) {
+		entries[i].addr = addr + (i * GRANULE_SIZE);
+		entries[i].iova = 0UL;
+	}
+
+	done = asc_mark_batch(ASC_BATCH_MARK_SECURE, 0UL, entries,
+			      (unsigned int)locked);
+
+	for (i = 0UL; i < done; i++) {
+		granule_set_state(g_run[i], GRANULE_STATE_DELEGATED);
+		granule_set_needs_scrub(g_run[i]);
+	}
+
+	for (i = 0UL; i < locked; i++) {
+		granule_unlock(g_run[i]);
+	}
+
+	return done;
+}
+
+static unsigned long undelegate_run(unsigned long addr, unsigned long count)
+{
+	struct granule *g_run[GRANULE_RANGE_BATCH];
+	struct asc_batch_entry entries[GRANULE_RANGE_BATCH];
+	unsigned long locked, done, i;
+
+	locked = find_lock_granule_run(addr, count, GRANULE_STATE_DELEGATED,
+				       g_run);
+
+	for (i = 0UL; i < locked; i++) {
+		entries[i].addr = addr + (i * GRANULE_SIZE);
+		entries[i].iova = 0UL;
+	}
+
+	done = asc_mark_batch(ASC_BATCH_MARK_NONSECURE, 0UL, entries,
+			      (unsigned int)locked);
+
+	for (i = 0UL; i < done; i++) {
+		granule_clear_needs_scrub(g_run[i]);
+		granule_set_state(g_run[i], GRANULE_STATE_NS);
+	}
+
+	for (i = 0UL; i < locked; i++) {
+		granule_unlock(g_run[i]);
+	}
+
+	return done;
+}
+
+/*
+ * Transition up to @count granules starting at @base, a batch of
+ * GRANULE_RANGE_BATCH granules at a time, using @transition_run.
+ *
+ * On success, ret_struct->x[1] is set to the address of the first granule
+ * which was not transitioned. The host resumes the operation from this
+ * address until it reaches the end of the range. RMI_ERROR_INPUT is returned
+ * if the arguments are invalid or if the granule at @base cannot be
+ * transitioned.
+ */
+static void granule_range_transition(unsigned long base,
+				     unsigned long count,
+				     unsigned long (*transition_run)(
+						unsigned long addr,
+						unsigned long count),
+				     struct smc_result *ret_struct)
+{
+	unsigned long todo = granule_range_count(base, count);
+	unsigned long addr = base;
+
+	while (todo != 0UL) {
+		unsigned long batch = (todo > GRANULE_RANGE_BATCH) ?
+					GRANULE_RANGE_BATCH : todo;
+		unsigned long done = transition_run(addr, batch);
+
+		addr += done * GRANULE_SIZE;
+		todo -= done;
+
+		if (done != batch) {
+			break;
+		}
+	}
+
+	if (addr == base) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	ret_struct->x[0] = RMI_SUCCESS;
+	ret_struct->x[1] = addr;
+}
+
+void smc_granule_delegate_range(unsigned long base,
+				unsigned long count,
+				struct smc_result *ret_struct)
+{
+	smc_granule_delegate_range_cca_marker();
+
+	granule_range_transition(base, count, delegate_run, ret_struct);
+}
+
+void smc_granule_undelegate_range(unsigned long base,
+				  unsigned long count,
+				  struct smc_result *ret_struct)
+{
+	smc_granule_undelegate_range_cca_marker();
+
+	granule_range_transition(base, count, undelegate_run, ret_struct);
+}
+
+unsigned long smc_granule_lock_stats(unsigned long ns_addr,
+				     unsigned long cpu_id)
+{
+	smc_granule_lock_stats_cca_marker();
+	struct granule *g_ns;
+	struct rmi_lock_stats stats;
+
+	g_ns = find_granule(ns_addr);
+	if ((g_ns == NULL) ||
+	    (granule_unlocked_state(g_ns) != GRANULE_STATE_NS)) {
+		return RMI_ERROR_INPUT;
+	}
+
+	if (cpu_id >= MAX_CPUS) {
+		return RMI_ERROR_INPUT;
+	}
+
+	/* Fails if the RMM is built without RMM_GRANULE_LOCK_STATS */
+	if (!granule_lock_stats_read((unsigned int)cpu_id, &stats)) {
+		return RMI_ERROR_INPUT;
+	}
+
+	if (!ns_buffer_write(SLOT_NS, g_ns, 0U, sizeof(stats), &stats)) {
+		return RMI_ERROR_INPUT;
+	}
+
+	return RMI_SUCCESS;
+}
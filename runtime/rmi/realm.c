@@ -51,7 +51,7 @@ static bool get_realm_params(struct rmi_realm_params *realm_params,
 	struct granule *g_realm_params;
 
 	g_realm_params = find_granule(realm_params_addr);
-	if ((g_realm_params == NULL) || (g_realm_params->state != GRANULE_STATE_NS)) {
+	if ((g_realm_params == NULL) || (granule_unlocked_state(g_realm_params) != GRANULE_STATE_NS)) {
 		return false;
 	}
 
@@ -161,6 +161,10 @@ static bool validate_realm_params(struct rmi_realm_params *p)
 		return false;
 	}
 
+	if ((p->flags & ~RMI_REALM_FLAGS_MASK) != 0UL) {
+		return false;
+	}
+
 	/* Check VMID collision and reserve it atomically if available */
 	return vmid_reserve((unsigned int)p->vmid);
 }
@@ -295,6 +299,7 @@ unsigned long smc_realm_create(unsigned long rd_addr,
 	}
 
 	rd = granule_map(g_rd, SLOT_RD);
+	granule_scrub_mapped_on_use(g_rd, rd);
 	set_rd_state(rd, REALM_STATE_NEW);
 	set_rd_rec_count(rd, 0UL);
 	rd->s2_ctx.g_rtt = find_granule(p.rtt_base);
@@ -304,6 +309,15 @@ unsigned long smc_realm_create(unsigned long rd_addr,
 	memcpy(&rd->rpv[0], &p.rpv[0], RPV_SIZE);
 
 	rd->s2_ctx.vmid = (unsigned int)p.vmid;
+	rd->rtt_gen = 0UL;
+	rd->rtt_readers = 0UL;
+	rd->walk_cache.g_tbl = NULL;
+	rd->fold_flags = p.flags;
+	rd->fold_head = 0U;
+	rd->fold_count = 0U;
+	rd->smmu_streams = 0UL;
+	(void)memset(rd->g_devs, 0, sizeof(rd->g_devs));
+	rd->nr_devs = 0U;
 
 	rd->num_rec_aux = MAX_REC_AUX_GRANULES;
 
@@ -326,6 +340,7 @@ unsigned long smc_realm_create(unsigned long rd_addr,
 	granule_unlock_transition(g_rd, GRANULE_STATE_RD);
 
 	for (i = 0U; i < p.rtt_num_start; i++) {
+		granule_scrub_on_use(g_rtt_base + i, SLOT_RTT);
 		granule_unlock_transition(g_rtt_base + i, GRANULE_STATE_RTT);
 	}
 
@@ -347,7 +362,7 @@ static unsigned long total_root_rtt_refcount(struct granule *g_rtt,
 		* deadlock free locking guarentee.
 		*/
 		granule_lock(g, GRANULE_STATE_RTT);
-		refcount += g->refcount;
+		refcount += granule_refcount_read(g);
 		granule_unlock(g);
 	}
 
@@ -133,8 +133,8 @@ static void init_rec_regs(struct rec *rec,
 	/*
 	 * We only need to set non-zero values here because we're intializing
 	 * data structures in the rec granule which was just converted from
-	 * the DELEGATED state to REC state, and we can rely on the RMM
-	 * invariant that DELEGATED granules are always zero-filled.
+	 * the DELEGATED state to REC state, and has been scrubbed by the
+	 * caller if it had not been zeroed since it was delegated.
 	 */
 
 	for (i = 0U; i < REC_CREATE_NR_GPRS; i++) {
@@ -154,21 +154,18 @@ static void init_rec_regs(struct rec *rec,
 }
 
 /*
- * This function will only be invoked when the REC create fails
- * or when REC is being destroyed. Hence the REC will not be in
- * use when this function is called and therefore no lock is
- * acquired before its invocation.
+ * This function will only be invoked when the REC is being destroyed.
+ * Hence the REC will not be in use when this function is called and
+ * therefore no lock is acquired before its invocation.
  */
 static void free_rec_aux_granules(struct granule *rec_aux[],
-				  unsigned int cnt, bool scrub)
+				  unsigned int cnt)
 {
 	for (unsigned int i = 0U; i < cnt; i++) {
 		struct granule *g_rec_aux = rec_aux[i];
 
 		granule_lock(g_rec_aux, GRANULE_STATE_REC_AUX);
-		if (scrub) {
-			granule_memzero(g_rec_aux, SLOT_REC_AUX0 + i);
-		}
+		granule_memzero(g_rec_aux, SLOT_REC_AUX0 + i);
 		granule_unlock_transition(g_rec_aux, GRANULE_STATE_DELEGATED);
 	}
 }
@@ -180,19 +177,19 @@ unsigned long smc_rec_create(unsigned long rec_addr,
 	struct granule *g_rd;
 	struct granule *g_rec;
 	struct granule *rec_aux_granules[MAX_REC_AUX_GRANULES];
+	struct granule_set granules[MAX_REC_AUX_GRANULES + 2U];
 	struct granule *g_rec_params;
 	struct rec *rec;
 	struct rd *rd;
 	struct rmi_rec_params rec_params;
 	unsigned long rec_idx;
-	enum granule_state new_rec_state = GRANULE_STATE_DELEGATED;
 	unsigned long ret;
 	bool ns_access_ok;
 	unsigned int num_rec_aux;
 	smc_rec_create_cca_marker();
 
 	g_rec_params = find_granule(rec_params_addr);
-	if ((g_rec_params == NULL) || (g_rec_params->state != GRANULE_STATE_NS)) {
+	if ((g_rec_params == NULL) || (granule_unlocked_state(g_rec_params) != GRANULE_STATE_NS)) {
 		return RMI_ERROR_INPUT;
 	}
 
@@ -208,27 +205,20 @@ unsigned long smc_rec_create(unsigned long rec_addr,
 		return RMI_ERROR_INPUT;
 	}
 
-	/* Loop through rec_aux_granules and transit them */
+	/* Lock the REC, the RD and the auxiliary granules in one pass */
+	granules[0] = (struct granule_set){0U, rec_addr,
+				GRANULE_STATE_DELEGATED, NULL, &g_rec};
+	granules[1] = (struct granule_set){1U, rd_addr,
+				GRANULE_STATE_RD, NULL, &g_rd};
 	for (unsigned int i = 0U; i < num_rec_aux; i++) {
-		struct granule *g_rec_aux = find_lock_granule(
-						rec_params.aux[i],
-						GRANULE_STATE_DELEGATED);
-		if (g_rec_aux == NULL) {
-			free_rec_aux_granules(rec_aux_granules, i, false);
-			return RMI_ERROR_INPUT;
-		}
-		granule_unlock_transition(g_rec_aux, GRANULE_STATE_REC_AUX);
-		rec_aux_granules[i] = g_rec_aux;
+		granules[i + 2U] = (struct granule_set){i + 2U,
+					rec_params.aux[i],
+					GRANULE_STATE_DELEGATED, NULL,
+					&rec_aux_granules[i]};
 	}
 
-	if (!find_lock_two_granules(rec_addr,
-				GRANULE_STATE_DELEGATED,
-				&g_rec,
-				rd_addr,
-				GRANULE_STATE_RD,
-				&g_rd)) {
-		ret = RMI_ERROR_INPUT;
-		goto out_free_aux;
+	if (!find_lock_granules(granules, num_rec_aux + 2UL)) {
+		return RMI_ERROR_INPUT;
 	}
 
 	rec = granule_map(g_rec, SLOT_REC);
@@ -252,6 +242,8 @@ unsigned long smc_rec_create(unsigned long rec_addr,
 		goto out_unmap;
 	}
 
+	granule_scrub_mapped_on_use(g_rec, rec);
+
 	rec->g_rec = g_rec;
 	rec->rec_idx = rec_idx;
 
@@ -278,7 +270,6 @@ unsigned long smc_rec_create(unsigned long rec_addr,
 	 * release/acquire semantics are not required.
 	 */
 	atomic_granule_get(g_rd);
-	new_rec_state = GRANULE_STATE_REC;
 	rec->runnable = rec_params.flags & REC_PARAMS_FLAG_RUNNABLE;
 
 	rec->alloc_info.ctx_initialised = false;
@@ -293,13 +284,20 @@ out_unmap:
 	buffer_unmap(rd);
 	buffer_unmap(rec);
 
-	granule_unlock(g_rd);
-	granule_unlock_transition(g_rec, new_rec_state);
-
-out_free_aux:
 	if (ret != RMI_SUCCESS) {
-		free_rec_aux_granules(rec_aux_granules, num_rec_aux, false);
+		granule_unlock_set(granules, num_rec_aux + 2UL);
+		return ret;
 	}
+
+	for (unsigned int i = 0U; i < num_rec_aux; i++) {
+		granule_scrub_on_use(rec_aux_granules[i], SLOT_REC_AUX0 + i);
+		granule_unlock_transition(rec_aux_granules[i],
+					  GRANULE_STATE_REC_AUX);
+	}
+
+	granule_unlock(g_rd);
+	granule_unlock_transition(g_rec, GRANULE_STATE_REC);
+
 	return ret;
 }
 
@@ -321,7 +319,7 @@ unsigned long smc_rec_destroy(unsigned long rec_addr)
 	g_rd = rec->realm_info.g_rd;
 
 	/* Free and scrub the auxiliary granules */
-	free_rec_aux_granules(rec->g_aux, rec->num_rec_aux, true);
+	free_rec_aux_granules(rec->g_aux, rec->num_rec_aux);
 
 	granule_memzero_mapped(rec);
 	buffer_unmap(rec);
@@ -5,6 +5,7 @@
  */
 
 #include <buffer.h>
+#include <dev.h>
 #include <granule.h>
 #include <measurement.h>
 #include <realm.h>
@@ -26,6 +27,11 @@ unsigned long dev_attach_flag(unsigned long flags){
 	return (flags & 0x00000002);
 }
 
+static unsigned int dev_attach_sid(unsigned long flags)
+{
+	return (unsigned int)EXTRACT(RMI_DATA_FLAGS_DEV_SID, flags);
+}
+
 /*
  * Validate the map_addr value passed to RMI_RTT_* and RMI_DATA_* commands.
  */
@@ -97,14 +103,11 @@ unsigned long smc_rtt_create(unsigned long rtt_addr,
 	struct granule *g_rd;
 	struct granule *g_tbl;
 	struct rd *rd;
-	struct granule *g_table_root;
 	struct rtt_walk wi;
 	unsigned long *s2tt, *parent_s2tt, parent_s2tte;
 	long level = (long)ulevel;
-	unsigned long ipa_bits;
 	unsigned long ret;
 	struct realm_s2_context s2_ctx;
-	int sl;
 
 	if (!find_lock_two_granules(rtt_addr,
 				    GRANULE_STATE_DELEGATED,
@@ -124,29 +127,25 @@ unsigned long smc_rtt_create(unsigned long rtt_addr,
 		return RMI_ERROR_INPUT;
 	}
 
-	g_table_root = rd->s2_ctx.g_rtt;
-	sl = realm_rtt_starting_level(rd);
-	ipa_bits = realm_ipa_bits(rd);
 	s2_ctx = rd->s2_ctx;
-	buffer_unmap(rd);
 
 	/*
-	 * Lock the RTT root. Enforcing locking order RD->RTT is enough to
+	 * Lock the parent RTT, either through the walk cache or by walking
+	 * from the RTT root. Enforcing locking order RD->RTT is enough to
 	 * ensure deadlock free locking guarentee.
 	 */
-	granule_lock(g_table_root, GRANULE_STATE_RTT);
+	parent_s2tt = rtt_walk_lock_unlock_cached(rd, map_addr, level - 1L,
+						  &wi);
+	buffer_unmap(rd);
 
-	/* Unlock RD after locking RTT Root */
+	/* Unlock RD after locking the parent RTT */
 	granule_unlock(g_rd);
 
-	rtt_walk_lock_unlock(g_table_root, sl, ipa_bits,
-				map_addr, level - 1L, &wi);
 	if (wi.last_level != level - 1L) {
 		ret = pack_return_code(RMI_ERROR_RTT, wi.last_level);
-		goto out_unlock_llt;
+		goto out_unmap_parent_table;
 	}
 
-	parent_s2tt = granule_map(wi.g_llt, SLOT_RTT);
 	parent_s2tte = s2tte_read(&parent_s2tt[wi.index]);
 	s2tt = granule_map(g_tbl, SLOT_DELEGATED);
 
@@ -251,49 +250,50 @@ unsigned long smc_rtt_create(unsigned long rtt_addr,
 
 	ret = RMI_SUCCESS;
 
+	/*
+	 * All the s2tt_init_*() helpers above write every entry of the new
+	 * table, so there is no need to zero it first.
+	 */
+	granule_clear_needs_scrub(g_tbl);
 	granule_set_state(g_tbl, GRANULE_STATE_RTT);
 
+	/*
+	 * Link the table with a store-release, so that the lock-free walk of
+	 * rtt_read_entry_lockless(), which reads the entry with acquire
+	 * semantics, observes the initialized table.
+	 */
 	parent_s2tte = s2tte_create_table(rtt_addr, level - 1L);
-	s2tte_write(&parent_s2tt[wi.index], parent_s2tte);
+	SCA_WRITE64_RELEASE(&parent_s2tt[wi.index], parent_s2tte);
 
 out_unmap_table:
 	buffer_unmap(s2tt);
+out_unmap_parent_table:
 	buffer_unmap(parent_s2tt);
-out_unlock_llt:
 	granule_unlock(wi.g_llt);
 	granule_unlock(g_tbl);
 	return ret;
 }
 
-unsigned long smc_rtt_fold(unsigned long rtt_addr,
-			   unsigned long rd_addr,
-			   unsigned long map_addr,
-			   unsigned long ulevel)
+/*
+ * Folds the RTT at @rtt_addr, which translates (@map_addr, @level), into its
+ * parent. The caller must hold the RD lock and have @rd mapped.
+ */
+static unsigned long rtt_fold(struct rd *rd,
+			      unsigned long rtt_addr,
+			      unsigned long map_addr,
+			      long level)
 {
-	smc_rtt_fold_cca_marker();
-	struct granule *g_rd;
 	struct granule *g_tbl;
-	struct rd *rd;
 	struct granule *g_table_root;
 	struct rtt_walk wi;
 	unsigned long *table, *parent_s2tt, parent_s2tte;
-	long level = (long)ulevel;
 	unsigned long ipa_bits;
 	unsigned long ret;
 	struct realm_s2_context s2_ctx;
 	int sl;
 	enum ripas ripas;
 
-	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
-	if (g_rd == NULL) {
-		return RMI_ERROR_INPUT;
-	}
-
-	rd = granule_map(g_rd, SLOT_RD);
-
 	if (!validate_rtt_structure_cmds(map_addr, level, rd)) {
-		buffer_unmap(rd);
-		granule_unlock(g_rd);
 		return RMI_ERROR_INPUT;
 	}
 
@@ -301,18 +301,20 @@ unsigned long smc_rtt_fold(unsigned long rtt_addr,
 	sl = realm_rtt_starting_level(rd);
 	ipa_bits = realm_ipa_bits(rd);
 	s2_ctx = rd->s2_ctx;
-	buffer_unmap(rd);
+
+	/*
+	 * The RD stays locked until the RTT has been removed from the tree, so
+	 * that the RTT walk cache can neither be used nor filled meanwhile.
+	 */
 	granule_lock(g_table_root, GRANULE_STATE_RTT);
-	granule_unlock(g_rd);
 
-	rtt_walk_lock_unlock(g_table_root, sl, ipa_bits,
-				map_addr, level - 1L, &wi);
+	parent_s2tt = rtt_walk_lock_unlock_map(g_table_root, sl, ipa_bits,
+					       map_addr, level - 1L, &wi);
 	if (wi.last_level != level - 1UL) {
 		ret = pack_return_code(RMI_ERROR_RTT, wi.last_level);
-		goto out_unlock_parent_table;
+		goto out_unmap_parent_table;
 	}
 
-	parent_s2tt = granule_map(wi.g_llt, SLOT_RTT);
 	parent_s2tte = s2tte_read(&parent_s2tt[wi.index]);
 	if (!s2tte_is_table(parent_s2tte, level - 1L)) {
 		ret = pack_return_code(RMI_ERROR_RTT,
@@ -344,7 +346,7 @@ unsigned long smc_rtt_fold(unsigned long rtt_addr,
 	 * We first check the table's ref. counter to speed up the case when
 	 * the host makes a guess whether a memory region can be folded.
 	 */
-	if (g_tbl->refcount == 0UL) {
+	if (granule_refcount_read(g_tbl) == 0UL) {
 		if (table_is_destroyed_block(table)) {
 			parent_s2tte = s2tte_create_destroyed();
 			__granule_put(wi.g_llt);
@@ -366,7 +368,7 @@ unsigned long smc_rtt_fold(unsigned long rtt_addr,
 			goto out_unmap_table;
 		}
 
-	} else if (g_tbl->refcount == S2TTES_PER_S2TT) {
+	} else if (granule_refcount_read(g_tbl) == S2TTES_PER_S2TT) {
 
 		unsigned long s2tte, block_pa;
 
@@ -413,6 +415,8 @@ unsigned long smc_rtt_fold(unsigned long rtt_addr,
 
 	ret = RMI_SUCCESS;
 
+	rtt_remove_begin(rd);
+
 	/*
 	 * Break before make.
 	 */
@@ -429,17 +433,164 @@ unsigned long smc_rtt_fold(unsigned long rtt_addr,
 
 	granule_memzero_mapped(table);
 	granule_set_state(g_tbl, GRANULE_STATE_DELEGATED);
+	rtt_remove_end(rd);
 
 out_unmap_table:
 	buffer_unmap(table);
 	granule_unlock(g_tbl);
 out_unmap_parent_table:
 	buffer_unmap(parent_s2tt);
-out_unlock_parent_table:
 	granule_unlock(wi.g_llt);
 	return ret;
 }
 
+unsigned long smc_rtt_fold(unsigned long rtt_addr,
+			   unsigned long rd_addr,
+			   unsigned long map_addr,
+			   unsigned long ulevel)
+{
+	smc_rtt_fold_cca_marker();
+	struct granule *g_rd;
+	struct rd *rd;
+	unsigned long ret;
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		return RMI_ERROR_INPUT;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+	ret = rtt_fold(rd, rtt_addr, map_addr, (long)ulevel);
+	buffer_unmap(rd);
+	granule_unlock(g_rd);
+	return ret;
+}
+
+/*
+ * Returns true if the RTT @s2tt at @level, referred to by @g_tbl, can be
+ * folded by RMI_RTT_FOLD into a block mapping, i.e. it holds 512 Assigned,
+ * Valid or Valid_NS s2ttes which map a contiguous block.
+ *
+ * The caller must hold the lock of @g_tbl.
+ */
+static bool rtt_is_foldable(struct granule *g_tbl, unsigned long *s2tt,
+			    long level)
+{
+	if ((level <= RTT_MIN_BLOCK_LEVEL) ||
+	    (granule_refcount_read(g_tbl) != S2TTES_PER_S2TT)) {
+		return false;
+	}
+
+	return table_maps_assigned_block(s2tt, level) ||
+	       table_maps_valid_block(s2tt, level) ||
+	       table_maps_valid_ns_block(s2tt, level);
+}
+
+/*
+ * Queues an RTT fold event in @rd. When the queue is full, the oldest event
+ * is dropped, which is only allowed for candidates: folded RTTs must always
+ * be reported to the Host so that it can reclaim them.
+ */
+static void rtt_fold_event_push(struct rd *rd, unsigned long type,
+				unsigned long ipa, long level,
+				unsigned long rtt_addr)
+{
+	struct rtt_fold_event *ev;
+
+	if (rd->fold_count == RTT_FOLD_EVENTS) {
+		assert(type == RMI_RTT_FOLD_EVENT_CANDIDATE);
+		rd->fold_head = (rd->fold_head + 1U) % RTT_FOLD_EVENTS;
+		rd->fold_count--;
+	}
+
+	ev = &rd->fold_events[(rd->fold_head + rd->fold_count) %
+			      RTT_FOLD_EVENTS];
+	ev->type = type;
+	ev->ipa = ipa;
+	ev->level = level;
+	ev->rtt_addr = rtt_addr;
+	rd->fold_count++;
+}
+
+/*
+ * Applies the RTT fold policy of the Realm to the RTT at @rtt_addr, which
+ * translates (@map_addr, @level) and was foldable when its lock was released.
+ *
+ * Must be called without holding any granule lock. The RTT may have changed
+ * in the meantime, in which case it is not folded, while a stale candidate
+ * is harmless as RMI_RTT_FOLD checks the RTT again.
+ */
+static void rtt_fold_policy(unsigned long rd_addr, unsigned long map_addr,
+			    long level, unsigned long rtt_addr)
+{
+	struct granule *g_rd;
+	struct rd *rd;
+	unsigned long ipa = map_addr & ~(s2tte_map_size(level - 1L) - 1UL);
+	unsigned long type;
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		return;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	if ((rd->fold_flags & RMI_REALM_FLAGS_FOLD_AUTO) != 0UL) {
+		/* Do not fold an RTT which cannot be reported */
+		if ((rd->fold_count == RTT_FOLD_EVENTS) ||
+		    (rtt_fold(rd, rtt_addr, ipa, level) != RMI_SUCCESS)) {
+			goto out_unmap_rd;
+		}
+		type = RMI_RTT_FOLD_EVENT_FOLDED;
+	} else if ((rd->fold_flags & RMI_REALM_FLAGS_FOLD_REPORT) != 0UL) {
+		type = RMI_RTT_FOLD_EVENT_CANDIDATE;
+	} else {
+		goto out_unmap_rd;
+	}
+
+	rtt_fold_event_push(rd, type, ipa, level, rtt_addr);
+
+out_unmap_rd:
+	buffer_unmap(rd);
+	granule_unlock(g_rd);
+}
+
+void smc_rtt_fold_query(unsigned long rd_addr,
+			struct smc_result *ret)
+{
+	smc_rtt_fold_query_cca_marker();
+	struct granule *g_rd;
+	struct rd *rd;
+	struct rtt_fold_event *ev;
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		ret->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	if (rd->fold_count == 0U) {
+		ret->x[1] = RMI_RTT_FOLD_EVENT_NONE;
+		ret->x[2] = 0UL;
+		ret->x[3] = 0UL;
+		ret->x[4] = 0UL;
+	} else {
+		ev = &rd->fold_events[rd->fold_head];
+		ret->x[1] = ev->type;
+		ret->x[2] = ev->ipa;
+		ret->x[3] = (unsigned long)ev->level;
+		ret->x[4] = ev->rtt_addr;
+		rd->fold_head = (rd->fold_head + 1U) % RTT_FOLD_EVENTS;
+		rd->fold_count--;
+	}
+
+	buffer_unmap(rd);
+	granule_unlock(g_rd);
+	ret->x[0] = RMI_SUCCESS;
+}
+
 unsigned long smc_rtt_destroy(unsigned long rtt_addr,
 			      unsigned long rd_addr,
 			      unsigned long map_addr,
@@ -477,18 +628,20 @@ unsigned long smc_rtt_destroy(unsigned long rtt_addr,
 	ipa_bits = realm_ipa_bits(rd);
 	s2_ctx = rd->s2_ctx;
 	in_par = addr_in_par(rd, map_addr);
-	buffer_unmap(rd);
+
+	/*
+	 * Keep the RD locked until the RTT has been removed from the tree, so
+	 * that the RTT walk cache can neither be used nor filled meanwhile.
+	 */
 	granule_lock(g_table_root, GRANULE_STATE_RTT);
-	granule_unlock(g_rd);
 
-	rtt_walk_lock_unlock(g_table_root, sl, ipa_bits,
-				map_addr, level - 1L, &wi);
+	parent_s2tt = rtt_walk_lock_unlock_map(g_table_root, sl, ipa_bits,
+					       map_addr, level - 1L, &wi);
 	if (wi.last_level != level - 1UL) {
 		ret = pack_return_code(RMI_ERROR_RTT, wi.last_level);
-		goto out_unlock_parent_table;
+		goto out_unmap_parent_table;
 	}
 
-	parent_s2tt = granule_map(wi.g_llt, SLOT_RTT);
 	parent_s2tte = s2tte_read(&parent_s2tt[wi.index]);
 	if (!s2tte_is_table(parent_s2tte, level - 1L)) {
 		ret = pack_return_code(RMI_ERROR_RTT,
@@ -520,7 +673,7 @@ unsigned long smc_rtt_destroy(unsigned long rtt_addr,
 	 * Read the refcount value. RTT granule is always accessed locked, thus
 	 * the refcount can be accessed without atomic operations.
 	 */
-	if (g_tbl->refcount != 0UL) {
+	if (granule_refcount_read(g_tbl) != 0UL) {
 		ret = RMI_ERROR_IN_USE;
 		goto out_unlock_table;
 	}
@@ -536,6 +689,7 @@ unsigned long smc_rtt_destroy(unsigned long rtt_addr,
 	}
 
 	__granule_put(wi.g_llt);
+	rtt_remove_begin(rd);
 
 	/*
 	 * Break before make. Note that this may cause spurious S2 aborts.
@@ -546,14 +700,16 @@ unsigned long smc_rtt_destroy(unsigned long rtt_addr,
 
 	granule_memzero_mapped(table);
 	granule_set_state(g_tbl, GRANULE_STATE_DELEGATED);
+	rtt_remove_end(rd);
 
 	buffer_unmap(table);
 out_unlock_table:
 	granule_unlock(g_tbl);
 out_unmap_parent_table:
 	buffer_unmap(parent_s2tt);
-out_unlock_parent_table:
 	granule_unlock(wi.g_llt);
+	buffer_unmap(rd);
+	granule_unlock(g_rd);
 	return ret;
 }
 
@@ -576,13 +732,12 @@ static unsigned long map_unmap_ns(unsigned long rd_addr,
 {
 	struct granule *g_rd;
 	struct rd *rd;
-	struct granule *g_table_root;
 	unsigned long *s2tt, s2tte;
 	struct rtt_walk wi;
-	unsigned long ipa_bits;
 	unsigned long ret;
 	struct realm_s2_context s2_ctx;
-	int sl;
+	unsigned long fold_flags;
+	unsigned long fold_rtt = 0UL;
 
 	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
 	if (g_rd == NULL) {
@@ -597,10 +752,6 @@ static unsigned long map_unmap_ns(unsigned long rd_addr,
 		return RMI_ERROR_INPUT;
 	}
 
-	g_table_root = rd->s2_ctx.g_rtt;
-	sl = realm_rtt_starting_level(rd);
-	ipa_bits = realm_ipa_bits(rd);
-
 	/*
 	 * We don't have to check PAR boundaries for unmap_ns
 	 * operation because we already test that the s2tte is Valid_NS
@@ -616,19 +767,16 @@ static unsigned long map_unmap_ns(unsigned long rd_addr,
 	}
 
 	s2_ctx = rd->s2_ctx;
+	fold_flags = rd->fold_flags;
+	s2tt = rtt_walk_lock_unlock_cached(rd, map_addr, level, &wi);
 	buffer_unmap(rd);
-
-	granule_lock(g_table_root, GRANULE_STATE_RTT);
 	granule_unlock(g_rd);
 
-	rtt_walk_lock_unlock(g_table_root, sl, ipa_bits,
-				map_addr, level, &wi);
 	if (wi.last_level != level) {
 		ret = pack_return_code(RMI_ERROR_RTT, wi.last_level);
-		goto out_unlock_llt;
+		goto out_unmap_table;
 	}
 
-	s2tt = granule_map(wi.g_llt, SLOT_RTT);
 	s2tte = s2tte_read(&s2tt[wi.index]);
 
 	if (op == MAP_NS) {
@@ -642,6 +790,11 @@ static unsigned long map_unmap_ns(unsigned long rd_addr,
 		s2tte_write(&s2tt[wi.index], s2tte);
 		__granule_get(wi.g_llt);
 
+		if ((fold_flags != 0UL) &&
+		    rtt_is_foldable(wi.g_llt, s2tt, level)) {
+			fold_rtt = granule_addr(wi.g_llt);
+		}
+
 	} else if (op == UNMAP_NS) {
 		/*
 		 * The following check also verifies that map_addr is outside
@@ -667,8 +820,11 @@ static unsigned long map_unmap_ns(unsigned long rd_addr,
 
 out_unmap_table:
 	buffer_unmap(s2tt);
-out_unlock_llt:
 	granule_unlock(wi.g_llt);
+
+	if (fold_rtt != 0UL) {
+		rtt_fold_policy(rd_addr, map_addr, level, fold_rtt);
+	}
 	return ret;
 }
 
@@ -695,6 +851,41 @@ unsigned long smc_rtt_unmap_unprotected(unsigned long rd_addr,
 	return map_unmap_ns(rd_addr, map_addr, (long)ulevel, 0UL, UNMAP_NS);
 }
 
+/*
+ * Returns the RmiRttEntryState of @s2tte at @level, and the output address or
+ * descriptor and the RIPAS reported for it in @desc and @ripas.
+ */
+static unsigned long rtt_entry_state(unsigned long s2tte, long level,
+				     unsigned long *desc, unsigned long *ripas)
+{
+	*desc = 0UL;
+	*ripas = 0UL;
+
+	if (s2tte_is_unassigned(s2tte)) {
+		*ripas = (unsigned long)s2tte_get_ripas(s2tte);
+		return RMI_RTT_STATE_UNASSIGNED;
+	} else if (s2tte_is_destroyed(s2tte)) {
+		return RMI_RTT_STATE_DESTROYED;
+	} else if (s2tte_is_assigned(s2tte, level)) {
+		*desc = s2tte_pa(s2tte, level);
+		*ripas = RMI_EMPTY;
+		return RMI_RTT_STATE_ASSIGNED;
+	} else if (s2tte_is_valid(s2tte, level)) {
+		*desc = s2tte_pa(s2tte, level);
+		*ripas = RMI_RAM;
+		return RMI_RTT_STATE_ASSIGNED;
+	} else if (s2tte_is_valid_ns(s2tte, level)) {
+		*desc = host_ns_s2tte(s2tte, level);
+		return RMI_RTT_STATE_VALID_NS;
+	} else if (s2tte_is_table(s2tte, level)) {
+		*desc = s2tte_pa_table(s2tte, level);
+		return RMI_RTT_STATE_TABLE;
+	}
+
+	assert(false);
+	return RMI_RTT_STATE_DESTROYED;
+}
+
 void smc_rtt_read_entry(unsigned long rd_addr,
 			unsigned long map_addr,
 			unsigned long ulevel,
@@ -732,43 +923,121 @@ void smc_rtt_read_entry(unsigned long rd_addr,
 	granule_lock(g_rtt_root, GRANULE_STATE_RTT);
 	granule_unlock(g_rd);
 
-	rtt_walk_lock_unlock(g_rtt_root, sl, ipa_bits,
-				map_addr, level, &wi);
-	s2tt = granule_map(wi.g_llt, SLOT_RTT);
+	s2tt = rtt_walk_lock_unlock_map(g_rtt_root, sl, ipa_bits,
+					map_addr, level, &wi);
 	s2tte = s2tte_read(&s2tt[wi.index]);
 	ret->x[1] =  wi.last_level;
-	ret->x[3] = 0UL;
-	ret->x[4] = 0UL;
+	ret->x[2] = rtt_entry_state(s2tte, wi.last_level, &ret->x[3],
+				    &ret->x[4]);
 
-	if (s2tte_is_unassigned(s2tte)) {
-		enum ripas ripas = s2tte_get_ripas(s2tte);
+	buffer_unmap(s2tt);
+	granule_unlock(wi.g_llt);
 
-		ret->x[2] = RMI_RTT_STATE_UNASSIGNED;
-		ret->x[4] = (unsigned long)ripas;
-	} else if (s2tte_is_destroyed(s2tte)) {
-		ret->x[2] = RMI_RTT_STATE_DESTROYED;
-	} else if (s2tte_is_assigned(s2tte, wi.last_level)) {
-		ret->x[2] = RMI_RTT_STATE_ASSIGNED;
-		ret->x[3] = s2tte_pa(s2tte, wi.last_level);
-		ret->x[4] = RMI_EMPTY;
-	} else if (s2tte_is_valid(s2tte, wi.last_level)) {
-		ret->x[2] = RMI_RTT_STATE_ASSIGNED;
-		ret->x[3] = s2tte_pa(s2tte, wi.last_level);
-		ret->x[4] = RMI_RAM;
-	} else if (s2tte_is_valid_ns(s2tte, wi.last_level)) {
-		ret->x[2] = RMI_RTT_STATE_VALID_NS;
-		ret->x[3] = host_ns_s2tte(s2tte, wi.last_level);
-	} else if (s2tte_is_table(s2tte, wi.last_level)) {
-		ret->x[2] = RMI_RTT_STATE_TABLE;
-		ret->x[3] = s2tte_pa_table(s2tte, wi.last_level);
-	} else {
-		assert(false);
+	ret->x[0] = RMI_SUCCESS;
+}
+
+/* Number of records buffered before they are written to the NS granule */
+#define RTT_READ_ENTRIES_CHUNK		64U
+
+/* Maximum number of records written by RMI_RTT_READ_ENTRIES */
+#define RTT_READ_ENTRIES_MAX		\
+	(unsigned int)(GRANULE_SIZE / sizeof(unsigned long))
+
+COMPILER_ASSERT(RTT_READ_ENTRIES_MAX >= S2TTES_PER_S2TT);
+
+void smc_rtt_read_entries(unsigned long rd_addr,
+			  unsigned long base,
+			  unsigned long top,
+			  unsigned long list_addr,
+			  struct smc_result *ret)
+{
+	smc_rtt_read_entries_cca_marker();
+	struct granule *g_rd, *g_rtt_root, *g_list;
+	struct rd *rd;
+	struct rtt_walk wi;
+	unsigned long records[RTT_READ_ENTRIES_CHUNK];
+	unsigned long *s2tt, map_size, index, addr;
+	unsigned long ipa_bits;
+	unsigned int nr_records = 0U, nr_buffered = 0U;
+	bool ns_access_ok = true;
+	int sl;
+
+	g_list = find_granule(list_addr);
+	if ((g_list == NULL) ||
+	    (granule_unlocked_state(g_list) != GRANULE_STATE_NS)) {
+		ret->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		ret->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	if (!GRANULE_ALIGNED(base) || (base >= top) ||
+	    (top > realm_ipa_size(rd))) {
+		buffer_unmap(rd);
+		granule_unlock(g_rd);
+		ret->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	g_rtt_root = rd->s2_ctx.g_rtt;
+	sl = realm_rtt_starting_level(rd);
+	ipa_bits = realm_ipa_bits(rd);
+	buffer_unmap(rd);
+
+	granule_lock(g_rtt_root, GRANULE_STATE_RTT);
+	granule_unlock(g_rd);
+
+	/*
+	 * Read the entries of the last level RTT which translates @base, from
+	 * the entry which contains @base to the end of the RTT or to @top.
+	 */
+	s2tt = rtt_walk_lock_unlock_map(g_rtt_root, sl, ipa_bits,
+					base, RTT_PAGE_LEVEL, &wi);
+	map_size = s2tte_map_size((int)wi.last_level);
+	addr = base & ~(map_size - 1UL);
+
+	for (index = wi.index;
+	     (index < S2TTES_PER_S2TT) && (addr < top) && ns_access_ok;
+	     index++) {
+		unsigned long s2tte = s2tte_read(&s2tt[index]);
+		unsigned long state, desc, ripas;
+
+		state = rtt_entry_state(s2tte, wi.last_level, &desc, &ripas);
+		records[nr_buffered++] =
+			INPLACE(RMI_RTT_RECORD_STATE, state) |
+			INPLACE(RMI_RTT_RECORD_RIPAS, ripas) |
+			(desc & MASK(RMI_RTT_RECORD_ADDR));
+		addr += map_size;
+
+		if ((nr_buffered == RTT_READ_ENTRIES_CHUNK) ||
+		    ((index + 1UL) == S2TTES_PER_S2TT) || (addr >= top)) {
+			ns_access_ok = ns_buffer_write(SLOT_NS, g_list,
+					nr_records * (unsigned int)sizeof(records[0]),
+					nr_buffered * (unsigned int)sizeof(records[0]),
+					records);
+			nr_records += nr_buffered;
+			nr_buffered = 0U;
+		}
 	}
 
 	buffer_unmap(s2tt);
 	granule_unlock(wi.g_llt);
 
+	if (!ns_access_ok) {
+		ret->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
 	ret->x[0] = RMI_SUCCESS;
+	ret->x[1] = wi.last_level;
+	ret->x[2] = nr_records;
+	ret->x[3] = addr;
 }
 
 static void data_granule_measure(struct rd *rd, void *data,
@@ -837,7 +1106,7 @@ void read_bar_sizes(char* data, unsigned long *res){
 	for(int i = 0; i < 6; i++){
 		unsigned long size = 0;
 		for(int j = 0; j < 4; j++){
-			size = (size << 8) + data[start + j + (i * 4)];
+			size = (size << 8) + (unsigned char)data[start + j + (i * 4)];
 		}
 		res[i] = size;
 	}
@@ -849,115 +1118,157 @@ void read_ipa_pa(char* data, unsigned long *bar_ipa, unsigned long *bar_pa){
 		unsigned long pa = 0;
 
 		for(int j = 0; j < 8; j++){
-			ipa = (ipa << 8) + data[start + j + (i * 16)];
-			pa = (pa << 8) + data[start + (j+8) + (i * 16)];
+			ipa = (ipa << 8) + (unsigned char)data[start + j + (i * 16)];
+			pa = (pa << 8) + (unsigned char)data[start + (j+8) + (i * 16)];
 		}
 
 		bar_ipa[i] = ipa;
 		bar_pa[i] = pa;
 	}
 }
-unsigned long do_full_table_walk_check(unsigned long rd_addr,
-			       unsigned long map_addr[], unsigned long expected_pa[], int n){
-	struct granule *g_rd;
-	struct granule *g_table_root;
-	struct rtt_walk wi;
-	unsigned long s2tte, *s2tt;
-	struct rd *rd;
-	unsigned long ipa_bits;
-	unsigned long ret;
-	bool valid;
-	int sl;
 
-	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
-	if (g_rd == NULL) {
-		return RMI_ERROR_INPUT;
-	}
+/*
+ * Checks that the IPA range [@ipa, @ipa + @size) of the realm mapped at @rd is
+ * mapped to the PA range starting at @pa, by entries which are either valid or
+ * HIPAS=ASSIGNED, so that each granule of the PA range is a DATA granule of
+ * the realm. The RTTs are walked once per last level table and block entries
+ * are checked as a whole. Must be called with the rd granule lock held.
+ */
+static unsigned long check_dev_range(struct rd *rd, unsigned long ipa,
+				     unsigned long pa, unsigned long size)
+{
+	struct granule *g_table_root = rd->s2_ctx.g_rtt;
+	int sl = realm_rtt_starting_level(rd);
+	unsigned long ipa_bits = realm_ipa_bits(rd);
+	unsigned long end = ipa + size;
 
-	rd = granule_map(g_rd, SLOT_RD);
-	for(int i = 0; i < n ; i++){
-		if (!validate_map_addr(map_addr[i], RTT_PAGE_LEVEL, rd)) {
-			buffer_unmap(rd);
-			granule_unlock(g_rd);
-			return RMI_ERROR_INPUT;
-		}
+	if (!GRANULE_ALIGNED(ipa) || !GRANULE_ALIGNED(pa) || (end < ipa) ||
+	    (end > realm_ipa_size(rd))) {
+		return RMI_ERROR_INPUT;
 	}
 
-	g_table_root = rd->s2_ctx.g_rtt;
-	sl = realm_rtt_starting_level(rd);
-	ipa_bits = realm_ipa_bits(rd);
-	// s2_ctx = rd->s2_ctx;
-	buffer_unmap(rd);
+	while (ipa < end) {
+		struct rtt_walk wi;
+		unsigned long *s2tt, map_size;
+		unsigned long ret = RMI_SUCCESS;
 
-	for(int i = 0; i < n ; i++){
 		granule_lock(g_table_root, GRANULE_STATE_RTT);
-		granule_unlock(g_rd);
+		s2tt = rtt_walk_lock_unlock_map(g_table_root, sl, ipa_bits,
+						ipa, RTT_PAGE_LEVEL, &wi);
+		map_size = s2tte_map_size((int)wi.last_level);
+
+		for (unsigned long idx = wi.index;
+		     (idx < S2TTES_PER_S2TT) && (ipa < end); idx++) {
+			unsigned long s2tte = s2tte_read(&s2tt[idx]);
+			unsigned long offset = ipa & (map_size - 1UL);
+			unsigned long len = map_size - offset;
+
+			if (!s2tte_is_valid(s2tte, wi.last_level) &&
+			    !s2tte_is_assigned(s2tte, wi.last_level)) {
+				ret = pack_return_code(RMI_ERROR_RTT,
+						       (unsigned int)wi.last_level);
+				break;
+			}
 
-		rtt_walk_lock_unlock(g_table_root, sl, ipa_bits,
-					map_addr[i], RTT_PAGE_LEVEL, &wi);
-		if (wi.last_level != RTT_PAGE_LEVEL) {
-			ret = pack_return_code(RMI_ERROR_RTT, wi.last_level);
-					granule_unlock(wi.g_llt);
+			if ((s2tte_pa(s2tte, wi.last_level) + offset) != pa) {
+				ERROR("Invalid mapping found. IPA %lx expected_pa %lx\n",
+				      ipa, pa);
+				ret = RMI_ERROR_INPUT;
+				break;
+			}
 
-			return ret;
+			if (len > (end - ipa)) {
+				len = end - ipa;
+			}
+			ipa += len;
+			pa += len;
 		}
-		s2tt = granule_map(wi.g_llt, SLOT_RTT);
-		s2tte = s2tte_read(&s2tt[wi.index]);
 
-		valid = s2tte_is_valid(s2tte, RTT_PAGE_LEVEL);
-
-		/*
-		* Check if either HIPAS=ASSIGNED or map_addr is a
-		* valid Protected IPA.
-		*/
-		if (!valid && !s2tte_is_assigned(s2tte, RTT_PAGE_LEVEL)) {
-			ret = pack_return_code(RMI_ERROR_RTT, RTT_PAGE_LEVEL);
-			buffer_unmap(s2tt);
-			return ret;
-		}
-		ret = s2tte_pa(s2tte, RTT_PAGE_LEVEL);
-		if(!(ret == expected_pa[i])){
-			ERROR("Invalid mapping found. IPA %lx expected_pa %lx pa %lx", map_addr[i], expected_pa[i], ret);
-			buffer_unmap(s2tt);
-			granule_unlock(wi.g_llt);
-			return RMI_ERROR_INPUT;
-		}
-		ERROR("IPA %lx PA %lx\n", map_addr[i], ret);
 		buffer_unmap(s2tt);
 		granule_unlock(wi.g_llt);
-	}
-		
-	return 0;
-}
-
 
-unsigned int check_dev_addr_space(unsigned long rd_addr,  unsigned long bar_sizes[], unsigned long bar_ipa[], unsigned long bar_pa[]){
-	unsigned long check_ipa[1000];
-	unsigned long check_pa[1000];
-	int n = 0;
-	for(int i = 0; i < 6; i++){
-		unsigned long ipa = bar_ipa[i]; //map_addr
-		unsigned long pa = bar_pa[i];
-		for(int j = 0; j < bar_sizes[i]; j+=GRANULE_SIZE){
-			//check the ipa and pa are valid for the realm context 
-			struct granule *g_data = find_lock_granule( pa + j, GRANULE_STATE_DATA);
-			if (g_data == NULL) {
-				ERROR("Cannot lock granule at pa %lx i %d j %d \n", (pa + j), i , j);
-				return RMI_ERROR_INPUT;
-			}
-			//if we get the granule for the pa then add the pa and ipa to the check list
-			check_pa[n] = pa + j;
-			check_ipa[n] = ipa + j;
-			n++;
-			granule_unlock(g_data);
+		if (ret != RMI_SUCCESS) {
+			return ret;
 		}
 	}
-	assert(n<1000);
-	return do_full_table_walk_check(rd_addr, check_ipa, check_pa, n);
+
+	return RMI_SUCCESS;
 }
 
 /*
- * Implements both Data.Create and Data.CreateUnknown
+ * Checks that the BARs of the device attached to the realm whose RD is at
+ * @rd_addr are mapped in the realm as described by the attach granule.
+ */
+static unsigned long check_dev_addr_space(unsigned long rd_addr,
+					  unsigned long bar_sizes[],
+					  unsigned long bar_ipa[],
+					  unsigned long bar_pa[])
+{
+	struct granule *g_rd;
+	struct rd *rd;
+	unsigned long ret = RMI_SUCCESS;
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		return RMI_ERROR_INPUT;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	for (unsigned int i = 0U; (i < DEV_MAX_BARS) && (ret == RMI_SUCCESS);
+	     i++) {
+		if (bar_sizes[i] == 0UL) {
+			continue;
+		}
+
+		/* A BAR smaller than a granule still takes a whole granule */
+		ret = check_dev_range(rd, bar_ipa[i], bar_pa[i],
+				      round_up(bar_sizes[i], GRANULE_SIZE));
+	}
+
+	buffer_unmap(rd);
+	granule_unlock(g_rd);
+	return ret;
+}
+
+/*
+ * Records the BARs read from the attach granule in the descriptor of the
+ * device with StreamID @sid, assigned to the realm whose RD is at @rd_addr.
+ */
+static unsigned long dev_record_bars(unsigned long rd_addr, unsigned int sid,
+				     unsigned long bar_sizes[],
+				     unsigned long bar_ipa[],
+				     unsigned long bar_pa[])
+{
+	struct dev_bar bars[DEV_MAX_BARS];
+	struct granule *g_rd;
+	unsigned int nr_bars = 0U;
+	unsigned long ret;
+
+	for (unsigned int i = 0U; i < DEV_MAX_BARS; i++) {
+		if (bar_sizes[i] != 0UL) {
+			bars[nr_bars].ipa = bar_ipa[i];
+			bars[nr_bars].pa = bar_pa[i];
+			/* The range validated by check_dev_addr_space() */
+			bars[nr_bars].size = round_up(bar_sizes[i],
+						      GRANULE_SIZE);
+			nr_bars++;
+		}
+	}
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		return RMI_ERROR_INPUT;
+	}
+
+	ret = dev_attach(sid, g_rd, bars, nr_bars);
+
+	granule_unlock(g_rd);
+	return ret;
+}
+
+/*
+ * Implements both Data.Create and Data.CreateUnknown
  *
  * if @g_src == NULL, this implemented Data.CreateUnknown
  * and otherwise this implemented Data.Create.
@@ -970,17 +1281,15 @@ static unsigned long data_create(unsigned long data_addr,
 {
 	struct granule *g_data;
 	struct granule *g_rd;
-	struct granule *g_table_root;
 	struct rd *rd;
 	struct rtt_walk wi;
 	unsigned long s2tte, *s2tt;
 	enum ripas ripas;
 	enum granule_state new_data_state = GRANULE_STATE_DELEGATED;
-	unsigned long ipa_bits;
 	unsigned long ret;
 	int __unused meas_ret;
-	int sl;
 	bool ns_access_ok = false;
+	unsigned long fold_rtt = 0UL;
 
 	// ERROR("Data create ipa %lx pa %lx \n", map_addr, data_addr);
 	if (!find_lock_two_granules(data_addr,
@@ -1002,18 +1311,19 @@ static unsigned long data_create(unsigned long data_addr,
 		goto out_unmap_rd;
 	}
 
-	g_table_root = rd->s2_ctx.g_rtt;
-	sl = realm_rtt_starting_level(rd);
-	ipa_bits = realm_ipa_bits(rd);
-	granule_lock(g_table_root, GRANULE_STATE_RTT);
-	rtt_walk_lock_unlock(g_table_root, sl, ipa_bits,
-			     map_addr, RTT_PAGE_LEVEL, &wi);
+	/* The device must have been assigned to the realm with RMI_DEV_CREATE */
+	if (dev_attach_flag(flags) &&
+	    !dev_lookup(dev_attach_sid(flags), g_rd, NULL, NULL)) {
+		ret = RMI_ERROR_INPUT;
+		goto out_unmap_rd;
+	}
+
+	s2tt = rtt_walk_lock_unlock_cached(rd, map_addr, RTT_PAGE_LEVEL, &wi);
 	if (wi.last_level != RTT_PAGE_LEVEL) {
 		ret = pack_return_code(RMI_ERROR_RTT, wi.last_level);
-		goto out_unlock_ll_table;
+		goto out_unmap_ll_table;
 	}
 
-	s2tt = granule_map(wi.g_llt, SLOT_RTT);
 	s2tte = s2tte_read(&s2tt[wi.index]);
 	if (!s2tte_is_unassigned(s2tte)) {
 		ret = pack_return_code(RMI_ERROR_RTT, RTT_PAGE_LEVEL);
@@ -1042,6 +1352,8 @@ static unsigned long data_create(unsigned long data_addr,
 			goto out_unmap_ll_table;
 		}
 
+		/* The whole granule has been overwritten with the source */
+		granule_clear_needs_scrub(g_data);
 
 		//Pertie 
 		if(dev_attach_flag(flags)){
@@ -1051,6 +1363,8 @@ static unsigned long data_create(unsigned long data_addr,
 		data_granule_measure(rd, data, map_addr, measure_flag(flags));
 		buffer_unmap(data);
 		
+	} else {
+		granule_scrub_on_use(g_data, SLOT_DELEGATED);
 	}
 
 	new_data_state = GRANULE_STATE_DATA;
@@ -1062,23 +1376,36 @@ static unsigned long data_create(unsigned long data_addr,
 	s2tte_write(&s2tt[wi.index], s2tte);
 	__granule_get(wi.g_llt);
 
+	if ((rd->fold_flags != 0UL) &&
+	    rtt_is_foldable(wi.g_llt, s2tt, RTT_PAGE_LEVEL)) {
+		fold_rtt = granule_addr(wi.g_llt);
+	}
+
 	ret = RMI_SUCCESS;
 
 out_unmap_ll_table:
 	buffer_unmap(s2tt);
-out_unlock_ll_table:
 	granule_unlock(wi.g_llt);
 out_unmap_rd:
 	buffer_unmap(rd);
 	granule_unlock(g_rd);
 	granule_unlock_transition(g_data, new_data_state);
 
+	if (fold_rtt != 0UL) {
+		rtt_fold_policy(rd_addr, map_addr, RTT_PAGE_LEVEL, fold_rtt);
+	}
+
 	if ( ns_access_ok && dev_attach_flag(flags)){
-		if(check_dev_addr_space(rd_addr, bar_sizes, bar_ipa, bar_pa) != 0){
+		if(check_dev_addr_space(rd_addr, bar_sizes, bar_ipa, bar_pa) != RMI_SUCCESS){
 			//TODO[Supraja] at this point the granule is already in data state with some wrong data and the attestation is corrupted. Ideally, the Realm context should be destroyed.
 			ERROR("dev granule checks failed");
 			return RMI_ERROR_INPUT;
 		}
+		if (dev_record_bars(rd_addr, dev_attach_sid(flags), bar_sizes,
+				    bar_ipa, bar_pa) != RMI_SUCCESS) {
+			ERROR("dev attach failed");
+			return RMI_ERROR_INPUT;
+		}
 		CCA_RMI_DEV_ATTACH();
 		smc_attach_dev(data_addr);
 		data = granule_map(g_data, SLOT_DELEGATED);
@@ -1106,7 +1433,7 @@ unsigned long smc_data_create(unsigned long data_addr,
 	}
 
 	g_src = find_granule(src_addr);
-	if ((g_src == NULL) || (g_src->state != GRANULE_STATE_NS)) {
+	if ((g_src == NULL) || (granule_unlocked_state(g_src) != GRANULE_STATE_NS)) {
 		return RMI_ERROR_INPUT;
 	}
 
@@ -1123,21 +1450,292 @@ unsigned long smc_data_create_unknown(unsigned long data_addr,
 	return data_create(data_addr, rd_addr, map_addr, NULL, 0);
 }
 
+/*
+ * Maximum number of granules created by a single RMI_DATA_CREATE_RANGE call,
+ * which bounds the time spent in the RMM with the RD locked.
+ */
+#define DATA_CREATE_RANGE_MAX_GRANULES	(512UL)
+
+/* Number of DATA granules locked at once by RMI_DATA_CREATE_RANGE */
+#define DATA_CREATE_RANGE_BATCH		(32UL)
+
+/*
+ * Create the single DATA granule at @data_addr with RMI_DATA_CREATE, either to
+ * make progress or to report its exact error in @status.
+ *
+ * Returns the number of granules created.
+ */
+static unsigned long data_create_single(unsigned long data_addr,
+					unsigned long rd_addr,
+					unsigned long map_addr,
+					unsigned long src_addr,
+					unsigned long flags,
+					unsigned long *status)
+{
+	struct granule *g_src;
+
+	g_src = find_granule(src_addr);
+	if ((g_src == NULL) ||
+	    (granule_unlocked_state(g_src) != GRANULE_STATE_NS)) {
+		*status = RMI_ERROR_INPUT;
+		return 0UL;
+	}
+
+	*status = data_create(data_addr, rd_addr, map_addr, g_src, flags);
+	return (*status == RMI_SUCCESS) ? 1UL : 0UL;
+}
+
+/*
+ * Create @count DATA granules at @data_addr, mapped at @map_addr and populated
+ * from the NS granules at @src_addr, all three being the base of contiguous
+ * ranges. The target IPAs must be translated by the same last level RTT.
+ *
+ * The granules are processed in order, exactly as @count consecutive calls to
+ * RMI_DATA_CREATE would, so that the resulting RIM is the same.
+ *
+ * Returns the number of granules created. If it is lower than @count, @status
+ * is set to the error code of the first granule which was not created.
+ */
+static unsigned long data_create_run(unsigned long data_addr,
+				     unsigned long rd_addr,
+				     unsigned long map_addr,
+				     unsigned long src_addr,
+				     unsigned long flags,
+				     unsigned long count,
+				     unsigned long *status)
+{
+	struct granule_set granules[DATA_CREATE_RANGE_BATCH + 1UL];
+	struct granule *g_data[DATA_CREATE_RANGE_BATCH];
+	struct granule *g_rd, *g_src;
+	struct rd *rd;
+	struct rtt_walk wi;
+	unsigned long s2tte, *s2tt;
+	unsigned char *data;
+	unsigned long i, done = 0UL;
+	unsigned long fold_rtt = 0UL;
+	bool map_failed = false;
+
+	assert((count != 0UL) && (count <= DATA_CREATE_RANGE_BATCH));
+
+	for (i = 0UL; i < count; i++) {
+		granules[i].addr = data_addr + (i * GRANULE_SIZE);
+		granules[i].state = GRANULE_STATE_DELEGATED;
+		granules[i].g_ret = &g_data[i];
+	}
+	granules[count].addr = rd_addr;
+	granules[count].state = GRANULE_STATE_RD;
+	granules[count].g_ret = &g_rd;
+
+	if (!find_lock_granules(granules, count + 1UL)) {
+		/*
+		 * At least one of the granules cannot be locked. Fall back to
+		 * a single RMI_DATA_CREATE, to create the first granule or to
+		 * report its exact error.
+		 */
+		return data_create_single(data_addr, rd_addr, map_addr,
+					  src_addr, flags, status);
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	*status = validate_data_create(map_addr, rd);
+	if (*status != RMI_SUCCESS) {
+		goto out_unmap_rd;
+	}
+
+	s2tt = rtt_walk_lock_unlock_cached(rd, map_addr, RTT_PAGE_LEVEL, &wi);
+	if (wi.last_level != RTT_PAGE_LEVEL) {
+		*status = pack_return_code(RMI_ERROR_RTT, wi.last_level);
+		goto out_unmap_ll_table;
+	}
+
+	assert((wi.index + count) <= S2TTES_PER_S2TT);
+
+	/* Map all the DATA granules with a single translation table update */
+	data = buffer_map_window(data_addr, count, false);
+	if (data == NULL) {
+		/*
+		 * The window cannot be mapped. Once the locks are released,
+		 * fall back to a single RMI_DATA_CREATE, which maps the
+		 * granule in a slot.
+		 */
+		map_failed = true;
+		goto out_unmap_ll_table;
+	}
+
+	for (i = 0UL; i < count; i++) {
+		unsigned long ipa = map_addr + (i * GRANULE_SIZE);
+		void *page = data + (i * GRANULE_SIZE);
+		enum ripas ripas;
+
+		*status = validate_data_create(ipa, rd);
+		if (*status != RMI_SUCCESS) {
+			break;
+		}
+
+		s2tte = s2tte_read(&s2tt[wi.index + i]);
+		if (!s2tte_is_unassigned(s2tte)) {
+			*status = pack_return_code(RMI_ERROR_RTT,
+						   RTT_PAGE_LEVEL);
+			break;
+		}
+
+		g_src = find_granule(src_addr + (i * GRANULE_SIZE));
+		if ((g_src == NULL) ||
+		    (granule_unlocked_state(g_src) != GRANULE_STATE_NS)) {
+			*status = RMI_ERROR_INPUT;
+			break;
+		}
+
+		if (!ns_buffer_read(SLOT_NS, g_src, 0U, GRANULE_SIZE, page)) {
+			/*
+			 * Some data may be copied before the failure. Zero
+			 * the granule as it will remain in delegated state.
+			 */
+			(void)memset(page, 0, GRANULE_SIZE);
+			*status = RMI_ERROR_INPUT;
+			break;
+		}
+
+		/* The whole granule has been overwritten with the source */
+		granule_clear_needs_scrub(g_data[i]);
+		data_granule_measure(rd, page, ipa, measure_flag(flags));
+
+		ripas = s2tte_get_ripas(s2tte);
+		s2tte = (ripas == RMI_EMPTY) ?
+			s2tte_create_assigned_empty(data_addr +
+						    (i * GRANULE_SIZE),
+						    RTT_PAGE_LEVEL) :
+			s2tte_create_valid(data_addr + (i * GRANULE_SIZE),
+					   RTT_PAGE_LEVEL);
+
+		s2tte_write(&s2tt[wi.index + i], s2tte);
+		__granule_get(wi.g_llt);
+		granule_set_state(g_data[i], GRANULE_STATE_DATA);
+		done++;
+	}
+
+	buffer_unmap_window(data);
+
+	if ((done != 0UL) && (rd->fold_flags != 0UL) &&
+	    rtt_is_foldable(wi.g_llt, s2tt, RTT_PAGE_LEVEL)) {
+		fold_rtt = granule_addr(wi.g_llt);
+	}
+
+out_unmap_ll_table:
+	buffer_unmap(s2tt);
+	granule_unlock(wi.g_llt);
+out_unmap_rd:
+	buffer_unmap(rd);
+	granule_unlock_set(granules, count + 1UL);
+
+	if (map_failed) {
+		return data_create_single(data_addr, rd_addr, map_addr,
+					  src_addr, flags, status);
+	}
+
+	if (fold_rtt != 0UL) {
+		rtt_fold_policy(rd_addr, map_addr, RTT_PAGE_LEVEL, fold_rtt);
+	}
+	return done;
+}
+
+/*
+ * The range is created in batches of at most DATA_CREATE_RANGE_BATCH granules,
+ * which never span more than one last level RTT. Each batch locks its DATA
+ * granules together with the RD, as external granules have to be locked in
+ * address order and before any RTT, and then walks the RTTs again. Only the
+ * first batch of a last level RTT walks down from the root: the following
+ * ones hit the RD walk cache, which locks the cached last level RTT directly,
+ * so the cost of a walk per batch is one RTT lock rather than a full walk.
+ */
+void smc_data_create_range(unsigned long data_addr,
+			   unsigned long rd_addr,
+			   unsigned long map_addr,
+			   unsigned long src_addr,
+			   unsigned long flags,
+			   unsigned long count,
+			   struct smc_result *ret_struct)
+{
+	smc_data_create_range_cca_marker();
+	unsigned long status = RMI_SUCCESS;
+	unsigned long done = 0UL;
+
+	/* Device attach is only supported by RMI_DATA_CREATE */
+	if ((flags & ~(unsigned long)RMI_MEASURE_CONTENT) != 0UL) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	if ((count == 0UL) || !GRANULE_ALIGNED(data_addr) ||
+	    !GRANULE_ALIGNED(map_addr) || !GRANULE_ALIGNED(src_addr)) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	if (count > DATA_CREATE_RANGE_MAX_GRANULES) {
+		count = DATA_CREATE_RANGE_MAX_GRANULES;
+	}
+
+	/* None of the ranges may wrap around the address space */
+	if (((count - 1UL) > ((~0UL - data_addr) >> GRANULE_SHIFT)) ||
+	    ((count - 1UL) > ((~0UL - map_addr) >> GRANULE_SHIFT)) ||
+	    ((count - 1UL) > ((~0UL - src_addr) >> GRANULE_SHIFT))) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	while (done < count) {
+		unsigned long offset = done * GRANULE_SIZE;
+		unsigned long ipa = map_addr + offset;
+		unsigned long llt_left = S2TTES_PER_S2TT -
+			((ipa >> GRANULE_SHIFT) & (S2TTES_PER_S2TT - 1UL));
+		unsigned long batch = count - done;
+		unsigned long n;
+
+		/* A batch never spans more than one last level RTT */
+		if (batch > llt_left) {
+			batch = llt_left;
+		}
+		if (batch > DATA_CREATE_RANGE_BATCH) {
+			batch = DATA_CREATE_RANGE_BATCH;
+		}
+
+		n = data_create_run(data_addr + offset, rd_addr, ipa,
+				    src_addr + offset, flags, batch, &status);
+		done += n;
+
+		if (n != batch) {
+			break;
+		}
+	}
+
+	/*
+	 * Report the error only if no granule was created. Otherwise the Host
+	 * resumes the operation from the first granule which was not created
+	 * and gets the error from that call.
+	 */
+	if (done == 0UL) {
+		ret_struct->x[0] = status;
+		return;
+	}
+
+	ret_struct->x[0] = RMI_SUCCESS;
+	ret_struct->x[1] = done;
+}
+
 unsigned long smc_data_destroy(unsigned long rd_addr,
 			       unsigned long map_addr)
 {
 	smc_data_destroy_cca_marker();
 	struct granule *g_data;
 	struct granule *g_rd;
-	struct granule *g_table_root;
 	struct rtt_walk wi;
 	unsigned long data_addr, s2tte, *s2tt;
 	struct rd *rd;
-	unsigned long ipa_bits;
 	unsigned long ret;
 	struct realm_s2_context s2_ctx;
 	bool valid;
-	int sl;
 
 	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
 	if (g_rd == NULL) {
@@ -1152,22 +1750,22 @@ unsigned long smc_data_destroy(unsigned long rd_addr,
 		return RMI_ERROR_INPUT;
 	}
 
-	g_table_root = rd->s2_ctx.g_rtt;
-	sl = realm_rtt_starting_level(rd);
-	ipa_bits = realm_ipa_bits(rd);
+	/* The DATA granule may still be mapped by the SMMU */
+	if (rd->smmu_streams != 0UL) {
+		buffer_unmap(rd);
+		granule_unlock(g_rd);
+		return RMI_ERROR_IN_USE;
+	}
+
 	s2_ctx = rd->s2_ctx;
+	s2tt = rtt_walk_lock_unlock_cached(rd, map_addr, RTT_PAGE_LEVEL, &wi);
 	buffer_unmap(rd);
-
-	granule_lock(g_table_root, GRANULE_STATE_RTT);
 	granule_unlock(g_rd);
 
-	rtt_walk_lock_unlock(g_table_root, sl, ipa_bits,
-				map_addr, RTT_PAGE_LEVEL, &wi);
 	if (wi.last_level != RTT_PAGE_LEVEL) {
 		ret = pack_return_code(RMI_ERROR_RTT, wi.last_level);
-		goto out_unlock_ll_table;
+		goto out_unmap_ll_table;
 	}
-	s2tt = granule_map(wi.g_llt, SLOT_RTT);
 	s2tte = s2tte_read(&s2tt[wi.index]);
 
 	valid = s2tte_is_valid(s2tte, RTT_PAGE_LEVEL);
@@ -1214,11 +1812,480 @@ unsigned long smc_data_destroy(unsigned long rd_addr,
 
 out_unmap_ll_table:
 	buffer_unmap(s2tt);
-out_unlock_ll_table:
 	granule_unlock(wi.g_llt);
 	return ret;
 }
 
+/*
+ * Maximum number of granules released and of NS mappings removed by a single
+ * RMI_RTT_TEARDOWN call, which bounds the time spent with the RD locked.
+ */
+#define RTT_TEARDOWN_BUDGET		(512UL)
+
+/*
+ * Maximum number of mappings removed from an RTT before the TLB invalidations
+ * are issued and the DATA granules released.
+ */
+#define RTT_TEARDOWN_CHUNK		32U
+
+/* Number of entries of the list of released granules */
+#define RTT_TEARDOWN_LIST_ENTRIES	\
+	(unsigned int)(GRANULE_SIZE / sizeof(struct rmi_released_granules))
+
+struct rtt_teardown {
+	struct rd *rd;
+	int sl;
+	unsigned long base;
+	unsigned long top;
+	/* Address of the next RTT entry to tear down */
+	unsigned long addr;
+	/* Number of granules which can still be released or NS mappings removed */
+	unsigned long budget;
+	struct s2tlbi_batch batch;
+	/* NS granule holding the list of released granules */
+	struct granule *g_list;
+	/* Number of entries written to the list */
+	unsigned int nr_entries;
+	/* Last entry of the list, extended while the granules are contiguous */
+	struct rmi_released_granules cur;
+	/* Set when the list could not be written */
+	bool list_error;
+};
+
+static bool rtt_teardown_list_write(struct rtt_teardown *td,
+				    struct rmi_released_granules *entry)
+{
+	return ns_buffer_write(SLOT_NS, td->g_list,
+			       td->nr_entries *
+			       (unsigned int)sizeof(struct rmi_released_granules),
+			       (unsigned int)sizeof(struct rmi_released_granules),
+			       entry);
+}
+
+/*
+ * Writes the last entry to the list. If the write fails, the entry is lost
+ * and the teardown stops: the list granule was written before anything was
+ * torn down, so it has been made inaccessible by the Host during the command.
+ */
+static void rtt_teardown_list_flush(struct rtt_teardown *td)
+{
+	if (td->cur.count == 0UL) {
+		return;
+	}
+
+	if (rtt_teardown_list_write(td, &td->cur)) {
+		td->nr_entries++;
+	} else {
+		td->list_error = true;
+	}
+
+	td->cur.count = 0UL;
+}
+
+/*
+ * Returns true if this call can still spend @cost from its budget and write
+ * @entries more entries to the list.
+ */
+static bool rtt_teardown_can_release(struct rtt_teardown *td,
+				     unsigned long cost, unsigned int entries)
+{
+	unsigned int used = td->nr_entries + ((td->cur.count != 0UL) ? 1U : 0U);
+
+	return (cost <= td->budget) &&
+		((used + entries) <= RTT_TEARDOWN_LIST_ENTRIES) &&
+		!td->list_error;
+}
+
+static void rtt_teardown_report(struct rtt_teardown *td, unsigned long addr,
+				unsigned long count)
+{
+	assert(count <= td->budget);
+	td->budget -= count;
+
+	if ((td->cur.count != 0UL) &&
+	    ((td->cur.addr + (td->cur.count * GRANULE_SIZE)) == addr)) {
+		td->cur.count += count;
+		return;
+	}
+
+	rtt_teardown_list_flush(td);
+	td->cur.addr = addr;
+	td->cur.count = count;
+}
+
+/*
+ * Zeroes and releases to the DELEGATED state the @count DATA granules from
+ * @pa, which are no longer mapped and whose TLB entries have been invalidated.
+ */
+static void rtt_teardown_release_data(struct rtt_teardown *td,
+				      unsigned long pa, unsigned long count)
+{
+	for (unsigned long i = 0UL; i < count; i++) {
+		struct granule *g_data;
+
+		/*
+		 * The address is obtained from a locked RTT, which guarantees
+		 * the locking order.
+		 */
+		g_data = find_lock_granule(pa + (i * GRANULE_SIZE),
+					   GRANULE_STATE_DATA);
+		assert(g_data != NULL);
+		granule_memzero(g_data, SLOT_DELEGATED);
+		granule_unlock_transition(g_data, GRANULE_STATE_DELEGATED);
+	}
+
+	rtt_teardown_report(td, pa, count);
+}
+
+/*
+ * Returns true if the RTT at @level which translates @addr covers an IPA range
+ * contained in [base, top). The starting level RTTs are never covered.
+ */
+static bool rtt_teardown_covers(struct rtt_teardown *td, unsigned long addr,
+				long level)
+{
+	unsigned long size, start;
+
+	if (level <= (long)td->sl) {
+		return false;
+	}
+
+	size = s2tte_map_size((int)(level - 1L));
+	start = addr & ~(size - 1UL);
+
+	return (start >= td->base) && ((start + size) <= td->top);
+}
+
+/*
+ * Destroys the RTT at @rtt_addr, at @level, which translates @addr and holds
+ * no live entry, then its parents as long as they become empty and are
+ * covered by the range.
+ *
+ * Returns false if an empty RTT cannot be destroyed within the budget or the
+ * size of the list, in which case the teardown is to be resumed from @addr.
+ */
+static bool rtt_teardown_tables(struct rtt_teardown *td,
+				unsigned long rtt_addr,
+				unsigned long addr, long level)
+{
+	struct rtt_walk wi;
+	struct granule *g_tbl;
+	unsigned long *parent_s2tt, *table, parent_s2tte;
+
+	while (true) {
+		if (!rtt_teardown_can_release(td, 1UL, 1U)) {
+			td->addr = addr;
+			return false;
+		}
+
+		parent_s2tt = rtt_walk_lock_unlock_cached(td->rd, addr,
+							  level - 1L, &wi);
+
+		/*
+		 * RTTs are only removed with the RD locked, so the RTT is
+		 * still in the tree. It may have been populated again by a
+		 * concurrent command which does not hold the RD lock.
+		 */
+		assert(wi.last_level == (level - 1L));
+		parent_s2tte = s2tte_read(&parent_s2tt[wi.index]);
+		assert(s2tte_is_table(parent_s2tte, level - 1L) &&
+		       (s2tte_pa_table(parent_s2tte, level - 1L) == rtt_addr));
+
+		g_tbl = find_lock_granule(rtt_addr, GRANULE_STATE_RTT);
+		assert(g_tbl != NULL);
+
+		if (granule_refcount_read(g_tbl) != 0UL) {
+			granule_unlock(g_tbl);
+			break;
+		}
+
+		parent_s2tte = addr_in_par(td->rd, addr) ?
+				s2tte_create_destroyed() :
+				s2tte_create_invalid_ns();
+
+		__granule_put(wi.g_llt);
+		rtt_remove_begin(td->rd);
+
+		/*
+		 * Break before make. The walk caches are invalidated before
+		 * the RTT is released.
+		 */
+		s2tte_write(&parent_s2tt[wi.index], 0UL);
+		s2tlbi_batch_add(&td->batch, addr & ~(GRANULE_SIZE - 1UL),
+				 GRANULE_SIZE);
+		s2tlbi_batch_flush(&td->batch);
+		s2tte_write(&parent_s2tt[wi.index], parent_s2tte);
+
+		table = granule_map(g_tbl, SLOT_RTT2);
+		granule_memzero_mapped(table);
+		buffer_unmap(table);
+		granule_unlock_transition(g_tbl, GRANULE_STATE_DELEGATED);
+		rtt_remove_end(td->rd);
+		rtt_teardown_report(td, rtt_addr, 1UL);
+
+		/* Continue with the parent if it is now empty */
+		level--;
+		if ((granule_refcount_read(wi.g_llt) != 0UL) ||
+		    !rtt_teardown_covers(td, addr, level)) {
+			break;
+		}
+
+		rtt_addr = granule_addr(wi.g_llt);
+		buffer_unmap(parent_s2tt);
+		granule_unlock(wi.g_llt);
+	}
+
+	buffer_unmap(parent_s2tt);
+	granule_unlock(wi.g_llt);
+	return true;
+}
+
+/*
+ * Tears down the entries of the last level RTT reached by a walk to
+ * @td->addr, starting from @td->addr and until either the end of the RTT,
+ * @td->top, a table entry or RTT_TEARDOWN_CHUNK removed mappings. The RTT is
+ * then destroyed if it is empty and covered by the range.
+ *
+ * Returns false if the operation cannot continue, in which case the status is
+ * returned in @ret.
+ */
+static bool rtt_teardown_llt(struct rtt_teardown *td, unsigned long *ret)
+{
+	struct rmi_released_granules pending[RTT_TEARDOWN_CHUNK];
+	unsigned int nr_pending = 0U;
+	unsigned long cost = 0UL;
+	struct rtt_walk wi;
+	unsigned long s2tte, *s2tt, map_size, index, count;
+	unsigned long start = td->addr;
+	unsigned long rtt_addr = 0UL;
+	bool more = true, empty = false;
+	long level;
+
+	s2tt = rtt_walk_lock_unlock_cached(td->rd, td->addr, RTT_PAGE_LEVEL,
+					   &wi);
+	level = wi.last_level;
+	map_size = s2tte_map_size((int)level);
+
+	for (index = wi.index; index < S2TTES_PER_S2TT; index++) {
+		unsigned long entry = td->addr & ~(map_size - 1UL);
+		bool contained = (entry == td->addr) &&
+				 ((entry + map_size) <= td->top);
+
+		s2tte = s2tte_read(&s2tt[index]);
+
+		/* The next walk descends into the table */
+		if (s2tte_is_table(s2tte, level)) {
+			break;
+		}
+
+		if (s2tte_is_valid(s2tte, level) ||
+		    s2tte_is_assigned(s2tte, level)) {
+			count = map_size / GRANULE_SIZE;
+
+			if (!contained) {
+				*ret = pack_return_code(RMI_ERROR_RTT,
+							(unsigned int)level);
+				more = false;
+				break;
+			}
+
+			if (!rtt_teardown_can_release(td, cost + count,
+						      nr_pending + 1U)) {
+				more = false;
+				break;
+			}
+			cost += count;
+
+			/* Same transitions as RMI_DATA_DESTROY */
+			pending[nr_pending].addr = s2tte_pa(s2tte, level);
+			pending[nr_pending].count = count;
+			nr_pending++;
+
+			if (s2tte_is_valid(s2tte, level)) {
+				s2tte_write(&s2tt[index],
+					    s2tte_create_destroyed());
+				s2tlbi_batch_add(&td->batch, entry, map_size);
+			} else {
+				s2tte_write(&s2tt[index],
+					    s2tte_create_unassigned(RMI_EMPTY));
+			}
+			__granule_put(wi.g_llt);
+
+		} else if (s2tte_is_valid_ns(s2tte, level)) {
+			if (!contained) {
+				*ret = pack_return_code(RMI_ERROR_RTT,
+							(unsigned int)level);
+				more = false;
+				break;
+			}
+
+			if (!rtt_teardown_can_release(td, cost + 1UL,
+						      nr_pending)) {
+				more = false;
+				break;
+			}
+
+			s2tte_write(&s2tt[index], s2tte_create_invalid_ns());
+			s2tlbi_batch_add(&td->batch, entry, map_size);
+			__granule_put(wi.g_llt);
+			td->budget--;
+		}
+
+		td->addr = ((entry + map_size) < td->top) ?
+				(entry + map_size) : td->top;
+
+		if ((td->addr == td->top) ||
+		    (nr_pending == RTT_TEARDOWN_CHUNK)) {
+			break;
+		}
+	}
+
+	/* The mappings must be invalidated before the granules are released */
+	s2tlbi_batch_flush(&td->batch);
+
+	for (unsigned int i = 0U; i < nr_pending; i++) {
+		rtt_teardown_release_data(td, pending[i].addr,
+					  pending[i].count);
+	}
+
+	if ((granule_refcount_read(wi.g_llt) == 0UL) &&
+	    rtt_teardown_covers(td, start, level)) {
+		rtt_addr = granule_addr(wi.g_llt);
+		empty = true;
+	}
+
+	buffer_unmap(s2tt);
+	granule_unlock(wi.g_llt);
+
+	/*
+	 * The empty RTTs are destroyed even if the walk was stopped, so that
+	 * they are not left behind once @td->addr reaches @td->top.
+	 */
+	if (empty &&
+	    !rtt_teardown_tables(td, rtt_addr, start, level)) {
+		more = false;
+	}
+
+	return more && !td->list_error;
+}
+
+/*
+ * Returns the address from which a teardown stopped at @td->addr by its budget
+ * is to be resumed: the start of the largest RTT range which contains
+ * @td->addr and is covered by [base, top), so that the next call can destroy
+ * the RTTs which the current one has emptied.
+ */
+static unsigned long rtt_teardown_resume_addr(struct rtt_teardown *td)
+{
+	for (long level = (long)td->sl + 1L; level <= RTT_PAGE_LEVEL;
+	     level++) {
+		if (rtt_teardown_covers(td, td->addr, level)) {
+			return td->addr &
+				~(s2tte_map_size((int)(level - 1L)) - 1UL);
+		}
+	}
+
+	return td->addr;
+}
+
+void smc_rtt_teardown(unsigned long rd_addr,
+		      unsigned long base,
+		      unsigned long top,
+		      unsigned long list_addr,
+		      struct smc_result *ret_struct)
+{
+	smc_rtt_teardown_cca_marker();
+	struct granule *g_rd;
+	struct rtt_teardown td;
+	unsigned long ret = RMI_SUCCESS;
+	bool more = true;
+
+	td.g_list = find_granule(list_addr);
+	if ((td.g_list == NULL) ||
+	    (granule_unlocked_state(td.g_list) != GRANULE_STATE_NS)) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	/*
+	 * Write an empty first entry before anything is torn down, so that
+	 * an inaccessible list fails the command without a state change.
+	 */
+	td.nr_entries = 0U;
+	td.cur.addr = 0UL;
+	td.cur.count = 0UL;
+	if (!rtt_teardown_list_write(&td, &td.cur)) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	td.rd = granule_map(g_rd, SLOT_RD);
+	td.sl = realm_rtt_starting_level(td.rd);
+	td.base = base;
+	td.top = top;
+	td.addr = base;
+	td.budget = RTT_TEARDOWN_BUDGET;
+	td.list_error = false;
+	s2tlbi_batch_init(&td.batch, &td.rd->s2_ctx);
+
+	if (!GRANULE_ALIGNED(base) || !GRANULE_ALIGNED(top) ||
+	    (base >= top) || (top > realm_ipa_size(td.rd))) {
+		ret = RMI_ERROR_INPUT;
+		goto out_unmap_rd;
+	}
+
+	/* DATA granules may still be mapped by the SMMU */
+	if (td.rd->smmu_streams != 0UL) {
+		ret = RMI_ERROR_IN_USE;
+		goto out_unmap_rd;
+	}
+
+	/*
+	 * The RD stays locked until the end of the command, as RTTs are
+	 * removed from the tree.
+	 */
+	while (more && (td.addr < top)) {
+		more = rtt_teardown_llt(&td, &ret);
+	}
+
+	rtt_teardown_list_flush(&td);
+
+	if (td.list_error) {
+		/*
+		 * The granules are released before they are written to the
+		 * list, so the command succeeds and reports the entries which
+		 * could be written and where to resume from.
+		 */
+		ret = RMI_SUCCESS;
+	}
+
+	if ((ret == RMI_SUCCESS) && (td.addr < top)) {
+		/* Stopped by the budget or the size of the list */
+		td.addr = rtt_teardown_resume_addr(&td);
+	} else if ((td.nr_entries != 0U) || (td.addr != base)) {
+		/*
+		 * Report the error only if no progress was made. Otherwise the
+		 * Host resumes the operation from the returned address and
+		 * gets the error from that call.
+		 */
+		ret = RMI_SUCCESS;
+	}
+
+out_unmap_rd:
+	buffer_unmap(td.rd);
+	granule_unlock(g_rd);
+
+	ret_struct->x[0] = ret;
+	ret_struct->x[1] = td.addr;
+	ret_struct->x[2] = td.nr_entries;
+}
+
 static bool update_ripas(unsigned long *s2tte, unsigned long level,
 			 enum ripas ripas)
 {
@@ -1272,14 +2339,12 @@ unsigned long smc_rtt_init_ripas(unsigned long rd_addr,
 				 unsigned long ulevel)
 {
 	smc_rtt_init_ripas_cca_marker();
-	struct granule *g_rd, *g_rtt_root;
+	struct granule *g_rd;
 	struct rd *rd;
-	unsigned long ipa_bits;
 	struct rtt_walk wi;
 	unsigned long s2tte, *s2tt;
 	unsigned long ret;
 	long level = (long)ulevel;
-	int sl;
 
 	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
 	if (g_rd == NULL) {
@@ -1306,21 +2371,16 @@ unsigned long smc_rtt_init_ripas(unsigned long rd_addr,
 		return RMI_ERROR_INPUT;
 	}
 
-	g_rtt_root = rd->s2_ctx.g_rtt;
-	sl = realm_rtt_starting_level(rd);
-	ipa_bits = realm_ipa_bits(rd);
-
-	granule_lock(g_rtt_root, GRANULE_STATE_RTT);
-	granule_unlock(g_rd);
-
-	rtt_walk_lock_unlock(g_rtt_root, sl, ipa_bits,
-				map_addr, level, &wi);
+	/*
+	 * The RD stays locked until the end of the command, as the realm
+	 * measurement is updated.
+	 */
+	s2tt = rtt_walk_lock_unlock_cached(rd, map_addr, level, &wi);
 	if (wi.last_level != level) {
 		ret = pack_return_code(RMI_ERROR_RTT, wi.last_level);
-		goto out_unlock_llt;
+		goto out_unmap_llt;
 	}
 
-	s2tt = granule_map(wi.g_llt, SLOT_RTT);
 	s2tte = s2tte_read(&s2tt[wi.index]);
 
 	/* Allowed only for HIPAS=UNASSIGNED */
@@ -1339,12 +2399,153 @@ unsigned long smc_rtt_init_ripas(unsigned long rd_addr,
 
 out_unmap_llt:
 	buffer_unmap(s2tt);
-out_unlock_llt:
+	granule_unlock(wi.g_llt);
 	buffer_unmap(rd);
+	granule_unlock(g_rd);
+	return ret;
+}
+
+/*
+ * Maximum number of RTT entries updated by a single RMI_RTT_INIT_RIPAS_RANGE
+ * call, which bounds the time spent in the RMM with the RD locked.
+ */
+#define INIT_RIPAS_RANGE_MAX_ENTRIES	(512UL)
+
+/*
+ * Set RIPAS=RAM on the entries of the last level RTT reached by a walk to
+ * @*addr, starting from @*addr and until either the end of the RTT, @top or
+ * @*budget entries. The RIPAS descriptors are measured in order.
+ *
+ * On return, @*addr is the address of the first entry which was not updated
+ * and @*budget is decremented by the number of entries updated. Returns
+ * RMI_SUCCESS if the caller may continue with the next RTT, or the error code
+ * of the entry at @*addr otherwise.
+ */
+static unsigned long init_ripas_llt(struct rd *rd,
+				    unsigned long *addr,
+				    unsigned long top,
+				    unsigned long *budget)
+{
+	struct rtt_walk wi;
+	unsigned long s2tte, *s2tt, map_size, index;
+	unsigned long ret = RMI_SUCCESS;
+	long level;
+
+	s2tt = rtt_walk_lock_unlock_cached(rd, *addr, RTT_PAGE_LEVEL, &wi);
+	level = wi.last_level;
+	map_size = s2tte_map_size((int)level);
+
+	for (index = wi.index; index < S2TTES_PER_S2TT; index++) {
+		if (*budget == 0UL) {
+			break;
+		}
+
+		/* The entry must be fully contained in [addr, top) */
+		if (!addr_is_level_aligned(*addr, level) ||
+		    ((*addr + map_size) > top)) {
+			ret = pack_return_code(RMI_ERROR_RTT,
+					       (unsigned int)level);
+			break;
+		}
+
+		s2tte = s2tte_read(&s2tt[index]);
+
+		/*
+		 * A table entry means that a deeper level RTT has to be
+		 * walked, which is done by the next call.
+		 */
+		if (s2tte_is_table(s2tte, level)) {
+			break;
+		}
+
+		/* Allowed only for HIPAS=UNASSIGNED */
+		if (!s2tte_is_unassigned(s2tte)) {
+			ret = pack_return_code(RMI_ERROR_RTT,
+					       (unsigned int)level);
+			break;
+		}
+
+		s2tte |= s2tte_create_ripas(RMI_RAM);
+		s2tte_write(&s2tt[index], s2tte);
+
+		ripas_granule_measure(rd, *addr, level);
+
+		*addr += map_size;
+		(*budget)--;
+
+		if (*addr == top) {
+			break;
+		}
+	}
+
+	buffer_unmap(s2tt);
 	granule_unlock(wi.g_llt);
 	return ret;
 }
 
+void smc_rtt_init_ripas_range(unsigned long rd_addr,
+			      unsigned long base,
+			      unsigned long top,
+			      struct smc_result *ret_struct)
+{
+	smc_rtt_init_ripas_range_cca_marker();
+	struct granule *g_rd;
+	struct rd *rd;
+	unsigned long budget = INIT_RIPAS_RANGE_MAX_ENTRIES;
+	unsigned long addr = base;
+	unsigned long ret = RMI_SUCCESS;
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	if (get_rd_state_locked(rd) != REALM_STATE_NEW) {
+		ret = RMI_ERROR_REALM;
+		goto out_unmap_rd;
+	}
+
+	if (!GRANULE_ALIGNED(base) || !GRANULE_ALIGNED(top) ||
+	    (base >= top) || (top > realm_par_size(rd))) {
+		ret = RMI_ERROR_INPUT;
+		goto out_unmap_rd;
+	}
+
+	/*
+	 * The RD stays locked until the end of the command, as the realm
+	 * measurement is updated.
+	 */
+	while ((addr < top) && (budget != 0UL)) {
+		/*
+		 * The walk descends through table entries, so the first entry
+		 * of each RTT is either updated or reported as an error.
+		 */
+		ret = init_ripas_llt(rd, &addr, top, &budget);
+		if (ret != RMI_SUCCESS) {
+			break;
+		}
+	}
+
+	/*
+	 * Report the error only if no entry was updated. Otherwise the Host
+	 * resumes the operation from the returned address and gets the error
+	 * from that call.
+	 */
+	if (addr != base) {
+		ret = RMI_SUCCESS;
+	}
+
+out_unmap_rd:
+	buffer_unmap(rd);
+	granule_unlock(g_rd);
+
+	ret_struct->x[0] = ret;
+	ret_struct->x[1] = addr;
+}
+
 unsigned long smc_rtt_set_ripas(unsigned long rd_addr,
 				unsigned long rec_addr,
 				unsigned long map_addr,
@@ -1422,14 +2623,13 @@ unsigned long smc_rtt_set_ripas(unsigned long rd_addr,
 
 	granule_lock(g_rtt_root, GRANULE_STATE_RTT);
 
-	rtt_walk_lock_unlock(g_rtt_root, sl, ipa_bits,
-				map_addr, level, &wi);
+	s2tt = rtt_walk_lock_unlock_map(g_rtt_root, sl, ipa_bits,
+					map_addr, level, &wi);
 	if (wi.last_level != level) {
 		ret = pack_return_code(RMI_ERROR_RTT, wi.last_level);
-		goto out_unlock_llt;
+		goto out_unmap_llt;
 	}
 
-	s2tt = granule_map(wi.g_llt, SLOT_RTT);
 	s2tte = s2tte_read(&s2tt[wi.index]);
 
 	valid = s2tte_is_valid(s2tte, level);
@@ -1455,7 +2655,6 @@ unsigned long smc_rtt_set_ripas(unsigned long rd_addr,
 
 out_unmap_llt:
 	buffer_unmap(s2tt);
-out_unlock_llt:
 	granule_unlock(wi.g_llt);
 out_unmap_rd:
 	buffer_unmap(rd);
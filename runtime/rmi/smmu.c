@@ -0,0 +1,289 @@
+/*
+ * SPDX-License-Identifier: BSD-3-Clause
+ * SPDX-FileCopyrightText: Copyright TF-RMM Contributors.
+ */
+
+#include <buffer.h>
+#include <dev.h>
+#include <granule.h>
+#include <realm.h>
+#include <smc-handler.h>
+#include <smc-rmi.h>
+#include <smmu.h>
+#include <status.h>
+#include <stdint.h>
+#include <benchmark.h>
+
+/*
+ * Maximum number of granules mapped by a single RMI_SMMU_MAP call, which
+ * bounds the time spent with the RD locked.
+ */
+#define SMMU_MAP_MAX_GRANULES	(512UL)
+
+/*
+ * Maximum number of physically contiguous runs translated by a single walk of
+ * the RTTs of the realm.
+ */
+#define SMMU_MAP_RUNS		8U
+
+unsigned long smc_smmu_stream_create(unsigned long rd_addr,
+				     unsigned long sid,
+				     unsigned long root_addr)
+{
+	smc_smmu_stream_create_cca_marker();
+	struct granule *g_rd, *g_root;
+	struct rd *rd;
+	unsigned long ret;
+
+	if (sid > UINT32_MAX) {
+		return RMI_ERROR_INPUT;
+	}
+
+	if (!find_lock_two_granules(rd_addr,
+				    GRANULE_STATE_RD,
+				    &g_rd,
+				    root_addr,
+				    GRANULE_STATE_DELEGATED,
+				    &g_root)) {
+		return RMI_ERROR_INPUT;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	/* The device must have been assigned to the realm */
+	if (!dev_lookup((unsigned int)sid, g_rd, NULL, NULL)) {
+		ret = RMI_ERROR_INPUT;
+	} else {
+		ret = smmu_stream_create((unsigned int)sid, g_rd,
+					 rd->s2_ctx.vmid, g_root);
+	}
+
+	if (ret == RMI_SUCCESS) {
+		rd->smmu_streams++;
+		__granule_get(g_rd);
+	}
+
+	buffer_unmap(rd);
+	granule_unlock(g_root);
+	granule_unlock(g_rd);
+
+	return ret;
+}
+
+unsigned long smc_smmu_stream_destroy(unsigned long rd_addr,
+				      unsigned long sid)
+{
+	smc_smmu_stream_destroy_cca_marker();
+	struct granule *g_rd;
+	struct rd *rd;
+	unsigned long ret;
+
+	if (sid > UINT32_MAX) {
+		return RMI_ERROR_INPUT;
+	}
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		return RMI_ERROR_INPUT;
+	}
+
+	ret = smmu_stream_destroy((unsigned int)sid, g_rd);
+	if (ret == RMI_SUCCESS) {
+		rd = granule_map(g_rd, SLOT_RD);
+		assert(rd->smmu_streams != 0UL);
+		rd->smmu_streams--;
+		buffer_unmap(rd);
+		__granule_put(g_rd);
+	}
+
+	granule_unlock(g_rd);
+	return ret;
+}
+
+unsigned long smc_smmu_table_add(unsigned long rd_addr,
+				 unsigned long sid,
+				 unsigned long table_addr)
+{
+	smc_smmu_table_add_cca_marker();
+	struct granule *g_rd, *g_tbl;
+	unsigned long ret;
+
+	if (sid > UINT32_MAX) {
+		return RMI_ERROR_INPUT;
+	}
+
+	if (!find_lock_two_granules(rd_addr,
+				    GRANULE_STATE_RD,
+				    &g_rd,
+				    table_addr,
+				    GRANULE_STATE_DELEGATED,
+				    &g_tbl)) {
+		return RMI_ERROR_INPUT;
+	}
+
+	/* Fails unless the stream is owned by the realm */
+	ret = smmu_stream_table_add((unsigned int)sid, g_rd, g_tbl);
+
+	granule_unlock(g_tbl);
+	granule_unlock(g_rd);
+	return ret;
+}
+
+/*
+ * Maps the Protected IPA range [@base, @top) of the realm described by @rd in
+ * the SMMU stage 2 tables of StreamID @sid, using the IPA as IOVA. The RTTs of
+ * the realm are walked once per last level RTT, and the translated runs are
+ * mapped in the SMMU tables with block mappings where possible.
+ *
+ * The address from which the operation is to be resumed is returned in
+ * @next.
+ */
+static unsigned long smmu_map_range(struct rd *rd, struct granule *g_rd,
+				    unsigned int sid, unsigned long base,
+				    unsigned long top, unsigned long *next)
+{
+	unsigned long addr = base;
+	unsigned long ret = RMI_SUCCESS;
+
+	while (addr < top) {
+		struct s2_walk_run runs[SMMU_MAP_RUNS];
+		struct s2_walk_result walk_res = { 0UL };
+		unsigned int nr_runs = SMMU_MAP_RUNS;
+		enum s2_walk_status ws;
+		unsigned long mapped;
+
+		ws = realm_ipa_range_to_pa(rd, addr, top, runs, &nr_runs,
+					   &walk_res);
+		if (ws == WALK_INVALID_PARAMS) {
+			ret = RMI_ERROR_INPUT;
+			break;
+		}
+
+		if (ws == WALK_FAIL) {
+			ret = pack_return_code(RMI_ERROR_RTT,
+					       (unsigned int)walk_res.rtt_level);
+			break;
+		}
+
+		ret = smmu_stream_map(sid, g_rd, runs, nr_runs, &mapped);
+		addr += mapped;
+		if (ret != RMI_SUCCESS) {
+			break;
+		}
+	}
+
+	*next = addr;
+	return ret;
+}
+
+void smc_smmu_map(unsigned long rd_addr,
+		  unsigned long sid,
+		  unsigned long base,
+		  unsigned long top,
+		  struct smc_result *ret_struct)
+{
+	smc_smmu_map_cca_marker();
+	struct granule *g_rd;
+	struct rd *rd;
+	unsigned long next = base;
+
+	ret_struct->x[1] = base;
+
+	if ((sid > UINT32_MAX) || !GRANULE_ALIGNED(base) ||
+	    !GRANULE_ALIGNED(top) || (base >= top)) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	if ((top - base) > (SMMU_MAP_MAX_GRANULES << GRANULE_SHIFT)) {
+		top = base + (SMMU_MAP_MAX_GRANULES << GRANULE_SHIFT);
+	}
+
+	ret_struct->x[0] = smmu_map_range(rd, g_rd, (unsigned int)sid,
+					  base, top, &next);
+	ret_struct->x[1] = next;
+
+	buffer_unmap(rd);
+	granule_unlock(g_rd);
+}
+
+void smc_smmu_unmap(unsigned long rd_addr,
+		    unsigned long sid,
+		    unsigned long base,
+		    unsigned long top,
+		    struct smc_result *ret_struct)
+{
+	smc_smmu_unmap_cca_marker();
+	struct granule *g_rd;
+	unsigned long next = base;
+
+	ret_struct->x[1] = base;
+
+	if (sid > UINT32_MAX) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	g_rd = find_lock_granule(rd_addr, GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		ret_struct->x[0] = RMI_ERROR_INPUT;
+		return;
+	}
+
+	/* Fails unless the stream is owned by the realm */
+	ret_struct->x[0] = smmu_stream_unmap((unsigned int)sid, g_rd,
+					     base, top, &next);
+	ret_struct->x[1] = next;
+
+	granule_unlock(g_rd);
+}
+
+/*
+ * Maps the granule at @phys_addr, which must back the Protected IPA @iova of
+ * the realm owning StreamID @sid, at IOVA @iova in the SMMU stage 2 tables of
+ * the stream.
+ */
+unsigned long smc_add_page_to_smmu_tables(unsigned long phys_addr,
+					  unsigned long iova,
+					  unsigned int sid)
+{
+	struct s2_walk_run run;
+	struct s2_walk_result walk_res = { 0UL };
+	struct granule *g_rd;
+	struct rd *rd;
+	unsigned int nr_runs = 1U;
+	unsigned long ret, mapped;
+
+	g_rd = smmu_stream_rd(sid);
+	if (g_rd == NULL) {
+		return RMI_ERROR_INPUT;
+	}
+
+	/* The stream may have been destroyed in the meantime */
+	g_rd = find_lock_granule(granule_addr(g_rd), GRANULE_STATE_RD);
+	if (g_rd == NULL) {
+		return RMI_ERROR_INPUT;
+	}
+
+	rd = granule_map(g_rd, SLOT_RD);
+
+	if ((realm_ipa_range_to_pa(rd, iova, iova + GRANULE_SIZE, &run,
+				   &nr_runs, &walk_res) != WALK_SUCCESS) ||
+	    (run.pa != phys_addr)) {
+		ret = RMI_ERROR_INPUT;
+	} else {
+		ret = smmu_stream_map(sid, g_rd, &run, 1U, &mapped);
+	}
+
+	buffer_unmap(rd);
+	granule_unlock(g_rd);
+	return ret;
+}
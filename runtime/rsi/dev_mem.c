@@ -1,99 +1,231 @@
+#include <asc.h>
 #include <buffer.h>
+#include <dev.h>
 #include <granule.h>
 #include <realm.h>
 #include <rsi-dev-mem.h>
 #include <smc-rsi.h>
 #include <status.h>
 #include <string.h>
-#include <debug.h>
+
+/* Number of device granules locked and passed to EL3 together */
+#define DEV_MEM_ASC_BATCH	32U
+COMPILER_ASSERT(DEV_MEM_ASC_BATCH <= ASC_BATCH_MAX_ENTRIES);
+
+/*
+ * Maximum number of device granules transitioned by a single RSI_DEV_MEM
+ * call. This bounds the time spent in the RMM before returning to the Realm,
+ * which resumes the operation from the returned IPA.
+ */
+#define DEV_MEM_MAX_GRANULES	512UL
 
 /*
-    reg[1] : IPA 
-    reg[2] : 1 for delegate (NS -> Realm) 0 for undelegate (Realm -> NS)
-	reg[3] : size in number of granules 
-*/
-struct rsi_delegate_dev_mem_result handle_rsi_dev_mem(struct rec *rec, struct rmi_rec_exit *rec_exit){
-	    struct rsi_delegate_dev_mem_result res = { { false, 0UL } };
-        unsigned long ipa = rec->regs[1];
-        unsigned long delegate_flag = rec->regs[2];
-		unsigned long size = rec->regs[3];
-
-		unsigned long pas[size]; 
-		unsigned long ipas[size];
-		struct granule *grs[size];
-		//int sid = 31;
-
-		struct rd *rd;
-		
-
-		ipa = ipa & GRANULE_MASK;
-
-		if (!GRANULE_ALIGNED(ipa) || !addr_in_rec_par(rec, ipa)) {
-			res.smc_result = RSI_ERROR_INPUT;
-            INFO("[SMC_RSI_DEV_MEM] IPA is invalid \n\n");
+ * Maximum number of physically contiguous runs returned by a single range
+ * translation. Further runs are translated by the next walk.
+ */
+#define DEV_MEM_RUNS		8U
+
+/*
+ * Lock the DATA granules backing the @count device granules described by
+ * @entries, then hand them to EL3. When delegating, only the first granule of
+ * the whole range is passed to EL3.
+ *
+ * Returns the number of granules processed, which is either @count or 0 in
+ * case of error.
+ */
+static unsigned int dev_mem_batch(struct rec *rec,
+				  struct asc_batch_entry *entries,
+				  unsigned int count,
+				  struct rsi_delegate_dev_mem_result *res)
+{
+	struct granule_set grs[DEV_MEM_ASC_BATCH];
+	unsigned long delegate_flag = rec->dev_mem.delegate;
+	unsigned int i, n;
+
+	assert(count <= DEV_MEM_ASC_BATCH);
+
+	/*
+	 * The DATA granules cannot be destroyed while the RD
+	 * lock is held, so they are locked together here.
+	 */
+	for (i = 0U; i < count; i++) {
+		grs[i] = (struct granule_set){i, entries[i].addr,
+				GRANULE_STATE_DATA, NULL, NULL};
+	}
+
+	if (!find_lock_granules(grs, count)) {
+		res->smc_result = RSI_ERROR_INPUT;
+		return 0U;
+	}
+
+	n = count;
+	if (delegate_flag != 0UL) {
+		n = (entries[0].iova == rec->dev_mem.start) ? 1U : 0U;
+	}
+
+	if (n != 0U) {
+		if (smc_granule_delegate_dev(entries, n, delegate_flag) != n) {
+			res->smc_result = RSI_ERROR_INPUT;
+			count = 0U;
 		}
+	}
 
-		granule_lock(rec->realm_info.g_rd, GRANULE_STATE_RD);
-		rd = granule_map(rec->realm_info.g_rd, SLOT_RD);
-		int size_del = 0;
-		for(int i = 0; i < size; i++){
-			struct s2_walk_result walk_res;
-			enum s2_walk_status walk_status;
-			walk_status = realm_ipa_to_pa(rd, ipa, &walk_res);
-
-			if (walk_status == WALK_FAIL) {
-				if (s2_walk_result_match_ripas(&walk_res, RMI_EMPTY)) {
-					res.smc_result = RSI_ERROR_INPUT;
-				} else {
-					/* Exit to Host */
-					res.walk_result.abort = true;
-					res.walk_result.rtt_level = walk_res.rtt_level;
-				}
-				INFO("Walk failed in RSI deleagate dev PAS");
-				granule_unlock(walk_res.llt);
-				continue;
-			}
+	granule_unlock_set(grs, i);
+	return count;
+}
 
-			if (walk_status == WALK_INVALID_PARAMS) {
-				/* Return error to Realm */
-				res.smc_result = RSI_ERROR_INPUT;
-                INFO("Walk failed : invalid params");
-				granule_unlock(walk_res.llt);
-				continue;
-			}
-			grs[i] = find_granule(walk_res.pa);
-			pas[i] = walk_res.pa;
-			ipas[i] = ipa; 
-			size_del = size_del + 1;
-			ipa += GRANULE_SIZE;
-			// ERROR("DEV PAS: %lu\n\n\n", walk_res.pa);
-			granule_lock(grs[i], GRANULE_STATE_DATA);
-			granule_unlock(walk_res.llt);
+/*
+ * Translate [@ipa, @end) with a single RTT walk, which covers at most the IPA
+ * range of one last level table, and transition the translated granules in
+ * batches of DEV_MEM_ASC_BATCH. Must be called with the rd granule lock held.
+ *
+ * Returns the number of granules processed. If the translation reached @end
+ * or the end of the table, the caller walks again from the next IPA.
+ * Otherwise @res describes the error or the walk failure.
+ */
+static unsigned long dev_mem_range(struct rec *rec, struct rd *rd,
+				   unsigned long ipa, unsigned long end,
+				   struct rsi_delegate_dev_mem_result *res)
+{
+	struct s2_walk_run runs[DEV_MEM_RUNS];
+	struct asc_batch_entry entries[DEV_MEM_ASC_BATCH];
+	struct s2_walk_result walk_res = { 0UL };
+	enum s2_walk_status walk_status;
+	unsigned int nr_runs = DEV_MEM_RUNS;
+	unsigned int count = 0U;
+	unsigned long done = 0UL;
+
+	walk_status = realm_ipa_range_to_pa(rd, ipa, end, runs, &nr_runs,
+					    &walk_res);
+
+	if (walk_status == WALK_INVALID_PARAMS) {
+		/* Return error to Realm */
+		res->smc_result = RSI_ERROR_INPUT;
+		return 0UL;
+	}
+
+	if (walk_status == WALK_FAIL) {
+		if (s2_walk_result_match_ripas(&walk_res, RMI_EMPTY)) {
+			res->smc_result = RSI_ERROR_INPUT;
+		} else {
+			/* Exit to Host */
+			res->walk_result.abort = true;
+			res->walk_result.rtt_level = walk_res.rtt_level;
 		}
-		//Make SMC call to delegate dev pas on the granule now
-		for(int i = 0; i < size_del; i++){
-			INFO("calling smc_granule_delegate_dev ipa: %lx | delegate_flag: %lx\n",ipas[i], delegate_flag);
-			res.smc_result = smc_granule_delegate_dev(pas[i], delegate_flag, ipas[i]);
-			//res.smc_result = RSI_SUCCESS;
-			// if (res.smc_result != RSI_SUCCESS){
-			// 	ERROR("smc_granule_delegate_dev failed\n");
-			// }else{
-			// 	INFO("Success delegating dev mem at pa %lx ", pas[i]);
-			// }
-			if(delegate_flag){
-				break;
-			}
+		return 0UL;
+	}
+
+	/* The memory must be within the BARs of the devices attached to the Realm */
+	for (unsigned int r = 0U; r < nr_runs; r++) {
+		if (!dev_pa_range_owned(rd, runs[r].pa, runs[r].size)) {
+			res->smc_result = RSI_ERROR_INPUT;
+			return 0UL;
 		}
-		// Overwrite ipa with real PA
-		// rec->regs[3] = walk_res.pa;
-        //TODO[Supraja, Benedict] : add smc call to create S2 table entry for SMMU.
-		// * BENE: done through the exit to HV.
-		for(int i = 0; i < size_del; i++){
-			granule_unlock(grs[i]);
+	}
+
+	for (unsigned int r = 0U; r < nr_runs; r++) {
+		for (unsigned long off = 0UL; off < runs[r].size;
+		     off += GRANULE_SIZE) {
+			entries[count].addr = runs[r].pa + off;
+			entries[count].iova = runs[r].ipa + off;
+			count++;
+
+			if (count == DEV_MEM_ASC_BATCH) {
+				if (dev_mem_batch(rec, entries, count,
+						  res) != count) {
+					return done;
+				}
+				done += count;
+				count = 0U;
+			}
 		}
-		
-		// out_unmap_rd:
-		buffer_unmap(rd);
+	}
+
+	if ((count != 0U) &&
+	    (dev_mem_batch(rec, entries, count, res) == count)) {
+		done += count;
+	}
+
+	return done;
+}
+
+/*
+ * reg[1] : IPA
+ * reg[2] : 1 for delegate (NS -> Realm) 0 for undelegate (Realm -> NS)
+ * reg[3] : size in number of granules
+ *
+ * At most DEV_MEM_MAX_GRANULES granules are processed per call. The progress
+ * is kept in the REC and the IPA of the first granule not processed yet is
+ * returned in reg[1]. The Realm completes the operation by calling again with
+ * that IPA and the remaining size until the returned IPA reaches the end of
+ * the range.
+ */
+struct rsi_delegate_dev_mem_result handle_rsi_dev_mem(struct rec *rec,
+						      struct rmi_rec_exit *rec_exit)
+{
+	struct rsi_delegate_dev_mem_result res = { { false, 0UL } };
+	unsigned long ipa = rec->regs[1] & GRANULE_MASK;
+	unsigned long delegate_flag = rec->regs[2];
+	unsigned long size = rec->regs[3];
+	unsigned long end, limit;
+	struct rd *rd;
+
+	(void)rec_exit;
+
+	res.smc_result = RSI_SUCCESS;
+
+	end = ipa + (size << GRANULE_SHIFT);
+	if ((size == 0UL) || (((end - ipa) >> GRANULE_SHIFT) != size) ||
+	    (end <= ipa) || !region_in_rec_par(rec, ipa, end)) {
+		res.smc_result = RSI_ERROR_INPUT;
+		return res;
+	}
+
+	/*
+	 * Start a new operation unless this resumes the pending one, either
+	 * from the returned IPA or, after a Stage 2 abort was reported to the
+	 * Host, by re-executing the original call.
+	 */
+	if ((rec->dev_mem.start == rec->dev_mem.end) ||
+	    (end != rec->dev_mem.end) ||
+	    (delegate_flag != rec->dev_mem.delegate) ||
+	    ((ipa != rec->dev_mem.addr) && (ipa != rec->dev_mem.start))) {
+		rec->dev_mem.start = ipa;
+		rec->dev_mem.end = end;
+		rec->dev_mem.addr = ipa;
+		rec->dev_mem.delegate = delegate_flag;
+	}
+
+	limit = rec->dev_mem.addr + (DEV_MEM_MAX_GRANULES << GRANULE_SHIFT);
+	if ((limit < rec->dev_mem.addr) || (limit > end)) {
+		limit = end;
+	}
+
+	rd = granule_map(rec->realm_info.g_rd, SLOT_RD);
+
+	while (rec->dev_mem.addr < limit) {
+		unsigned long done;
+
+		/* The RD lock is only held for one walk at a time */
+		granule_lock(rec->realm_info.g_rd, GRANULE_STATE_RD);
+		done = dev_mem_range(rec, rd, rec->dev_mem.addr, limit, &res);
 		granule_unlock(rec->realm_info.g_rd);
-        return res;
-}
\ No newline at end of file
+
+		rec->dev_mem.addr += done << GRANULE_SHIFT;
+		if ((done == 0UL) || (res.smc_result != RSI_SUCCESS) ||
+		    res.walk_result.abort) {
+			break;
+		}
+	}
+
+	buffer_unmap(rd);
+
+	res.next_ipa = rec->dev_mem.addr;
+	if (rec->dev_mem.addr == rec->dev_mem.end) {
+		/* The operation is complete */
+		rec->dev_mem.start = 0UL;
+		rec->dev_mem.end = 0UL;
+	}
+
+	return res;
+}
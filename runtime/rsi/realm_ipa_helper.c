@@ -50,14 +50,12 @@ enum s2_walk_status realm_ipa_to_pa(struct rd *rd,
 	 */
 	g_table_root = rd->s2_ctx.g_rtt;
 	granule_lock(g_table_root, GRANULE_STATE_RTT);
-	rtt_walk_lock_unlock(g_table_root,
-			     realm_rtt_starting_level(rd),
-			     realm_ipa_bits(rd),
-			     ipa,
-			     RTT_PAGE_LEVEL,
-			     &wi);
-
-	ll_table = granule_map(wi.g_llt, SLOT_RTT);
+	ll_table = rtt_walk_lock_unlock_map(g_table_root,
+					    realm_rtt_starting_level(rd),
+					    realm_ipa_bits(rd),
+					    ipa,
+					    RTT_PAGE_LEVEL,
+					    &wi);
 
 	/* Must be unlocked by caller */
 	s2_walk->llt = wi.g_llt;
@@ -93,6 +91,112 @@ out_unmap_table:
 	return walk_status;
 }
 
+/**
+ * Translate a range of realm granule IPAs to PAs with a single RTT walk.
+ *
+ * The walk goes down to the last level table which translates @ipa, then the
+ * following entries of that table are read without walking again. Physically
+ * contiguous granules, including the ones mapped by a block entry, are
+ * coalesced into a single run.
+ *
+ * The translation stops at the first of:
+ * - @end,
+ * - the end of the IPA range translated by the last level table,
+ * - the first entry which is not valid,
+ * - @runs being full.
+ *
+ * As for realm_ipa_to_pa(), the caller must hold the rd granule lock so that
+ * the DATA granules in the returned runs cannot be destroyed. The last level
+ * table is unlocked on return.
+ *
+ * Parameters:
+ * [in]     rd		  Pointer to realm descriptor granule.
+ * [in]     ipa		  The IPA of the first realm granule.
+ * [in]     end		  The first IPA after the range.
+ * [out]    runs	  Translated runs, in increasing IPA order.
+ * [in,out] nr_runs	  In: capacity of @runs. Out: number of runs returned.
+ * [out]    s2_walk	  If WALK_FAIL is returned, describes the entry for
+ *			  @ipa as realm_ipa_to_pa() does. 'llt' is not set.
+ * Returns:
+ * WALK_SUCCESS		At least the granule at @ipa was translated.
+ * WALK_INVALID_PARAMS	The range is unaligned, empty or not Protected IPA.
+ * WALK_FAIL		Mapping of @ipa is not in the page table.
+ */
+enum s2_walk_status realm_ipa_range_to_pa(struct rd *rd,
+					  unsigned long ipa,
+					  unsigned long end,
+					  struct s2_walk_run *runs,
+					  unsigned int *nr_runs,
+					  struct s2_walk_result *s2_walk)
+{
+	struct granule *g_table_root;
+	struct rtt_walk wi;
+	unsigned long *ll_table, map_size, idx;
+	unsigned int n = 0U;
+
+	assert(*nr_runs != 0U);
+
+	if (!GRANULE_ALIGNED(ipa) || !GRANULE_ALIGNED(end) || (end <= ipa) ||
+	    (end > realm_par_size(rd))) {
+		return WALK_INVALID_PARAMS;
+	}
+
+	g_table_root = rd->s2_ctx.g_rtt;
+	granule_lock(g_table_root, GRANULE_STATE_RTT);
+	ll_table = rtt_walk_lock_unlock_map(g_table_root,
+					    realm_rtt_starting_level(rd),
+					    realm_ipa_bits(rd),
+					    ipa,
+					    RTT_PAGE_LEVEL,
+					    &wi);
+
+	map_size = s2tte_map_size((int)wi.last_level);
+
+	for (idx = wi.index; (idx < S2TTES_PER_S2TT) && (ipa < end); idx++) {
+		unsigned long s2tte = s2tte_read(&ll_table[idx]);
+		unsigned long offset, pa, size;
+
+		if (!s2tte_is_valid(s2tte, wi.last_level)) {
+			if (n == 0U) {
+				s2_walk->rtt_level = wi.last_level;
+				if (s2tte_is_destroyed(s2tte)) {
+					s2_walk->destroyed = true;
+				} else {
+					s2_walk->ripas = s2tte_get_ripas(s2tte);
+				}
+			}
+			break;
+		}
+
+		offset = ipa & (map_size - 1UL);
+		pa = s2tte_pa(s2tte, wi.last_level) + offset;
+		size = map_size - offset;
+		if (size > (end - ipa)) {
+			size = end - ipa;
+		}
+
+		if ((n != 0U) && ((runs[n - 1U].pa + runs[n - 1U].size) == pa)) {
+			runs[n - 1U].size += size;
+		} else {
+			if (n == *nr_runs) {
+				break;
+			}
+			runs[n].ipa = ipa;
+			runs[n].pa = pa;
+			runs[n].size = size;
+			n++;
+		}
+
+		ipa += size;
+	}
+
+	buffer_unmap(ll_table);
+	granule_unlock(wi.g_llt);
+
+	*nr_runs = n;
+	return (n != 0U) ? WALK_SUCCESS : WALK_FAIL;
+}
+
 /*
  * Get RIPAS of IPA
  *
@@ -113,38 +217,48 @@ enum s2_walk_status realm_ipa_get_ripas(struct rec *rec, unsigned long ipa,
 {
 	unsigned long s2tte, *ll_table;
 	struct rtt_walk wi;
-	enum s2_walk_status ws;
+	struct rd *rd;
+	long level;
+	bool found;
 
 	assert(ripas_ptr != NULL);
 	assert(rtt_level != NULL);
 	assert(GRANULE_ALIGNED(ipa));
 	assert(addr_in_rec_par(rec, ipa));
 
-	granule_lock(rec->realm_info.g_rtt, GRANULE_STATE_RTT);
+	/*
+	 * Try a lock-free walk first, which does not contend with the RMI
+	 * commands updating other parts of the RTT tree, and fall back to a
+	 * locked walk if it conflicts with the removal of an RTT.
+	 */
+	rd = granule_map(rec->realm_info.g_rd, SLOT_RD);
+	found = rtt_read_entry_lockless(rd, ipa, &s2tte, &level);
+	buffer_unmap(rd);
 
-	rtt_walk_lock_unlock(rec->realm_info.g_rtt,
-			     rec->realm_info.s2_starting_level,
-			     rec->realm_info.ipa_bits,
-			     ipa, RTT_PAGE_LEVEL, &wi);
+	if (!found) {
+		granule_lock(rec->realm_info.g_rtt, GRANULE_STATE_RTT);
 
-	ll_table = granule_map(wi.g_llt, SLOT_RTT);
-	s2tte = s2tte_read(&ll_table[wi.index]);
+		ll_table = rtt_walk_lock_unlock_map(rec->realm_info.g_rtt,
+						rec->realm_info.s2_starting_level,
+						rec->realm_info.ipa_bits,
+						ipa, RTT_PAGE_LEVEL, &wi);
+		s2tte = s2tte_read(&ll_table[wi.index]);
+		level = wi.last_level;
+
+		buffer_unmap(ll_table);
+		granule_unlock(wi.g_llt);
+	}
 
 	if (s2tte_is_destroyed(s2tte)) {
-		*rtt_level = wi.last_level;
+		*rtt_level = (unsigned long)level;
 		/*
 		 * The IPA has been destroyed by NS Host. Return data_abort back
 		 * to NS Host and there is no recovery possible of this Rec
 		 * after this.
 		 */
-		ws = WALK_FAIL;
-	} else {
-		*ripas_ptr = s2tte_get_ripas(s2tte);
-		ws = WALK_SUCCESS;
+		return WALK_FAIL;
 	}
 
-	buffer_unmap(ll_table);
-	granule_unlock(wi.g_llt);
-
-	return ws;
+	*ripas_ptr = s2tte_get_ripas(s2tte);
+	return WALK_SUCCESS;
 }